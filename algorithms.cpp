@@ -1,6 +1,5 @@
 #include <stddef.h>
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/properties.hpp>
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <iterator>
@@ -8,60 +7,140 @@
 #include "algorithms.hpp"
 #include "scheduling.hpp"
 
-#include <boost/graph/subgraph.hpp>
-#include <boost/graph/topological_sort.hpp>
+#include <boost/iterator/counting_iterator.hpp>
 #include <numeric>
 
-Schedule lsl(const Graph &g, const Configurations &C, size_t L)
+Schedule lsl(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    size_t                     L,
+    Placement                  placement,
+    Ordering                   ordering,
+    Reconfiguration            reconfiguration,
+    std::pmr::memory_resource *mem,
+    ThreadPool                *pool)
 {
-  Schedule            S(C);
-  std::vector<Vertex> sorted_g;
-  boost::topological_sort(g, std::back_inserter(sorted_g));
+  return lsl(
+      g,
+      W,
+      C,
+      T,
+      R,
+      priority_order(g, T, ordering, mem),
+      L,
+      placement,
+      reconfiguration,
+      mem,
+      pool);
+}
+
+Schedule lsl(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    const Order               &sorted_g,
+    size_t                     L,
+    Placement                  placement,
+    Reconfiguration            reconfiguration,
+    std::pmr::memory_resource *mem,
+    ThreadPool                *pool)
+{
+  Schedule            S(C, W, placement, mem);
 
   auto c_current     = C.begin();
   auto c_last        = C.end();
   int  last_reconfig = 0;
 
+  std::pmr::vector<std::optional<int>> c_distance(C.size(), mem);
+
+  // Sum of min(cost under a, cost under c) over the lookahead window
+  // [i, i + L) for every pair of configurations (a, c), and the number of
+  // tasks in the window which neither a nor c supports. The sums are slid
+  // along with i, so the lookahead costs O(C^2) per task independent of L.
+  const size_t               nc = C.size();
+  std::pmr::vector<int64_t>  window_cost(nc * nc, 0, mem);
+  std::pmr::vector<int32_t>  window_unsupported(nc * nc, 0, mem);
+
+  auto slide_row = [&](size_t a, Vertex task, int sign) {
+    const int cost_a = T.min_cost(task, a);
+    for (size_t c = 0; c < nc; c++) {
+      // When we use both of these configurations, this will be the cost at
+      // minimum. Or we cannot execute the task at all.
+      const int cost = std::min(cost_a, T.min_cost(task, c));
+      if (cost == CostMatrix::Unsupported) {
+        window_unsupported[a * nc + c] += sign;
+      }
+      else {
+        window_cost[a * nc + c] += sign * cost;
+      }
+    }
+  };
+
+  for (size_t offset = 0; offset < std::min(L, sorted_g.size()); offset++) {
+    for (size_t a = 0; a < nc; a++) {
+      slide_row(a, sorted_g[offset], 1);
+    }
+  }
+
+  // With many configurations the rows of the window sums are slid in
+  // parallel, a block of tasks at a time. The sums of every task of the block
+  // are kept, since the current configuration is only known when the task is
+  // scheduled.
+  const bool   parallel = pool && pool->size() > 1 && nc >= ParallelLookahead;
+  const size_t block    = parallel ? std::max<size_t>(1, (1 << 18) / (nc * nc))
+                                   : 1;
+  std::pmr::vector<int64_t> block_cost(parallel ? block * nc * nc : 0, mem);
+  std::pmr::vector<int32_t> block_unsupported(
+      parallel ? block * nc * nc : 0, mem);
+
   for (size_t i = 0; i < sorted_g.size(); i++) {
+    const size_t current = std::distance(C.begin(), c_current);
+
+    const int64_t *costs       = &window_cost[current * nc];
+    const int32_t *unsupported = &window_unsupported[current * nc];
+    if (parallel) {
+      if (i % block == 0) {
+        const size_t end = std::min(i + block, sorted_g.size());
+        pool->parallel_for(0, nc, [&](size_t a) {
+          for (size_t k = i; k < end; k++) {
+            const size_t row = ((k - i) * nc + a) * nc;
+            std::copy_n(&window_cost[a * nc], nc, &block_cost[row]);
+            std::copy_n(
+                &window_unsupported[a * nc], nc, &block_unsupported[row]);
+            if (L > 0) {
+              slide_row(a, sorted_g[k], -1);
+            }
+            if (L > 0 && k + L < sorted_g.size()) {
+              slide_row(a, sorted_g[k + L], 1);
+            }
+          }
+        });
+      }
+      costs       = &block_cost[((i % block) * nc + current) * nc];
+      unsupported = &block_unsupported[((i % block) * nc + current) * nc];
+    }
+
     // distance from current configuration
-    std::vector<std::optional<int>> c_distance(C.size(), rho);
-    c_distance[std::distance(C.begin(), c_current)] = 0;
+    for (size_t c = 0; c < nc; c++) {
+      c_distance[c] = R.cost(current, c);
+    }
 
     // accumulate the cost for each configuration
     std::transform(
-        C.begin(),
-        C.end(),
+        boost::counting_iterator<size_t>(0),
+        boost::counting_iterator<size_t>(C.size()),
         c_distance.begin(),
         c_distance.begin(),
-        [&](const auto c, const auto acc) {
-          if (!acc) {
-            return acc;
+        [&](const size_t c, const auto acc) {
+          if (unsupported[c] > 0) {
+            return std::optional<int>{};
           }
-
-          auto tmp_acc = acc;
-          for (size_t offset = i; offset < std::min(i + L, sorted_g.size());
-               offset++) {
-            auto task         = g[sorted_g[offset]];
-            auto current_cost = c_current->min_cost(task);
-            auto other_cost   = c.min_cost(task);
-
-            if (offset == i && (!current_cost && !other_cost)) {
-                return std::optional<int>();
-            }
-
-            // When we use both of these configurations, this will be the cost
-            // at minimum.
-            if (current_cost || other_cost) {
-              tmp_acc = tmp_acc.value() + std::min(
-                                              current_cost.value_or(INT_MAX),
-                                              other_cost.value_or(INT_MAX));
-            }
-            else {
-              // Or we cannot execute the tasks at all.
-              return std::optional<int>{};
-            }
-          }
-          return tmp_acc;
+          return std::optional<int>(acc.value() + static_cast<int>(costs[c]));
         });
 
     // select the configuration with minimal cost
@@ -79,81 +158,362 @@ Schedule lsl(const Graph &g, const Configurations &C, size_t L)
         });
 
 
-    auto task     = g[sorted_g[i]];
+    auto task     = sorted_g[i];
 
-    auto c_next = std::next(
-          C.begin(), std::distance(c_distance.begin(), best_config));
+    const size_t next = std::distance(c_distance.begin(), best_config);
 
     // If the next configuration supports the current task, switch.
-    if(c_next->min_cost(task)) {
-      c_current = c_next;
+    if(T.supports(task, next)) {
+      c_current = std::next(C.begin(), next);
     }
 
 
-    auto asap     = S.earliest_finish(task, *c_current);
-    auto best_t_s = asap.second;
-    auto preds    = adjacent_vertices(sorted_g[i], g);
+    auto preds = g.preds(task);
 
     // find the latest t_f of all predecessors
-    best_t_s = std::transform_reduce(
-        preds.first,
-        preds.second,
-        best_t_s,
+    auto ready = std::transform_reduce(
+        preds.begin(),
+        preds.end(),
+        0,
         [](const auto lhs, const auto rhs) { return std::max(lhs, rhs); },
-        [&](const auto pred) { return S.t_f(g[pred]); });
+        [&](const auto pred) { return S.t_f(pred); });
+
+    if (reconfiguration == Reconfiguration::Partial) {
+      // Only the region of the PE is reconfigured, if at all
+      auto slot = S.earliest_region(
+          R, std::distance(C.begin(), c_current), task, ready + 1);
+      S.schedule_on_region(R, task, slot.first, slot.second);
+    }
+    else {
+      if (c_current != c_last) {
+        last_reconfig = S.insert_reconfiguration(R.cost(
+            std::distance(C.begin(), c_last),
+            std::distance(C.begin(), c_current)));
+        c_last = c_current;
+      }
+
+      if (placement == Placement::Insertion) {
+        auto gap = S.earliest_gap(
+            *c_current, task, std::max(ready, last_reconfig) + 1);
+        S.schedule_task(task, gap.first, gap.second);
+      }
+      else {
+        auto asap = S.earliest_finish(task, *c_current);
+        S.schedule_task(
+            task,
+            asap.first,
+            std::max({asap.second, ready, last_reconfig}) + 1);
+      }
+    }
 
-    if (c_current != c_last) {
-      c_last        = c_current;
-      last_reconfig = S.insert_reconfiguration(rho);
+    // slide the lookahead window by one task
+    for (size_t a = 0; a < nc && !parallel; a++) {
+      if (L > 0) {
+        slide_row(a, task, -1);
+      }
+      if (L > 0 && i + L < sorted_g.size()) {
+        slide_row(a, sorted_g[i + L], 1);
+      }
     }
-    S.schedule_task(task, asap.first, std::max(best_t_s, last_reconfig) + 1);
   }
 
   return S;
 }
 
-Schedule cluster(Graph &g, Configurations &C)
+Schedule cluster(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    Placement                  placement,
+    Segmentation               segmentation,
+    Ordering                   ordering,
+    Reconfiguration            reconfiguration,
+    std::pmr::memory_resource *mem)
 {
-  Schedule   S(C);
-  Clustering clustering(std::move(g), C);
+  return cluster(
+      g,
+      W,
+      C,
+      T,
+      R,
+      priority_order(g, T, ordering, mem),
+      placement,
+      segmentation,
+      reconfiguration,
+      mem);
+}
+
+Schedule cluster(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    const Order               &order,
+    Placement                  placement,
+    Segmentation               segmentation,
+    Reconfiguration            reconfiguration,
+    std::pmr::memory_resource *mem)
+{
+  Schedule   S(C, W, placement, mem);
+  Clustering clustering(g, Order(order, mem), T, R, C, mem);
 
   // Assign initial cost and configurations to clusters
 
-  bool done = false;
-  while (not done) {
-    done = clustering.merge();
+  if (segmentation == Segmentation::Optimal) {
+    clustering.segment();
+  }
+  else {
+    bool done = false;
+    while (not done) {
+      done = clustering.merge();
+    }
   }
 
-  auto last_reconfig = 0;
+  auto   last_reconfig = 0;
+  size_t last_config   = C.size();
   for (auto cluster : clustering.clusters) {
-    if (not cluster.is_empty()) {
-      last_reconfig = S.insert_reconfiguration(rho);
+    if (reconfiguration == Reconfiguration::Global &&
+        not cluster.is_empty() &&
+        clustering.config_index(cluster) != last_config) {
+      const size_t config = clustering.config_index(cluster);
+      last_reconfig = S.insert_reconfiguration(R.cost(last_config, config));
+      last_config   = config;
     }
     for (auto it = cluster.front; it != cluster.back; ++it) {
-      auto& task = clustering.graph[*it];
-      auto asap = S.asap(*cluster.config, task);
- 
       // find the latest t_f of all predecessors
-      auto preds    = adjacent_vertices(*it, clustering.graph);
-      auto best_t_s = asap.second;
-      best_t_s      = std::transform_reduce(
-          preds.first,
-          preds.second,
-          best_t_s,
+      auto preds = g.preds(*it);
+      auto ready = std::transform_reduce(
+          preds.begin(),
+          preds.end(),
+          last_reconfig,
           [](const auto lhs, const auto rhs) { return std::max(lhs, rhs); },
-          [&](const auto pred) { return S.t_f(g[pred]) + 1; });
-      S.schedule_task(clustering.graph[*it], asap.first, std::max(best_t_s, last_reconfig + 1));
+          [&](const auto pred) { return S.t_f(pred); });
+
+      if (reconfiguration == Reconfiguration::Partial) {
+        auto slot = S.earliest_region(
+            R, clustering.config_index(cluster), *it, ready + 1);
+        S.schedule_on_region(R, *it, slot.first, slot.second);
+      }
+      else if (placement == Placement::Insertion) {
+        auto gap = S.earliest_gap(*cluster.config, *it, ready + 1);
+        S.schedule_task(*it, gap.first, gap.second);
+      }
+      else {
+        auto asap = S.asap(*cluster.config, *it);
+        S.schedule_task(*it, asap.first, std::max(asap.second, ready + 1));
+      }
     }
   }
 
   return S;
 }
 
-Clustering::Clustering(Graph &&g, const Configurations &configs)
-  : graph(std::move(g))
-  , C(configs)
+Schedule heft(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    Placement                  placement,
+    Reconfiguration            reconfiguration,
+    std::pmr::memory_resource *mem)
 {
-  boost::topological_sort(g, std::back_inserter(order));
+  Schedule     S(C, W, placement, mem);
+  const auto  &sorted_g = g.order();
+  const size_t n        = sorted_g.size();
+  const size_t nc       = C.size();
+
+  const auto rank = upward_ranks(g, T, mem);
+
+  // Position in the topological order breaks ties between equal ranks
+  std::pmr::vector<size_t> position(n, 0, mem);
+  for (size_t i = 0; i < n; i++) {
+    position[sorted_g[i]] = i;
+  }
+  auto lower_priority = [&](const Vertex lhs, const Vertex rhs) {
+    if (rank[lhs] != rank[rhs]) {
+      return rank[lhs] < rank[rhs];
+    }
+    return position[lhs] > position[rhs];
+  };
+
+  // Number of unscheduled predecessors of each task; tasks without any are
+  // in the ready list, a max-heap on the priority
+  std::pmr::vector<uint32_t> waiting(n, 0, mem);
+  std::pmr::vector<Vertex>   ready_list(mem);
+  ready_list.reserve(n);
+  for (auto v : sorted_g) {
+    waiting[v] = g.preds(v).size();
+    if (waiting[v] == 0) {
+      ready_list.push_back(v);
+      std::push_heap(ready_list.begin(), ready_list.end(), lower_priority);
+    }
+  }
+
+  size_t current       = nc;
+  int    last_reconfig = 0;
+  while (not ready_list.empty()) {
+    std::pop_heap(ready_list.begin(), ready_list.end(), lower_priority);
+    const auto task = ready_list.back();
+    ready_list.pop_back();
+
+    auto preds = g.preds(task);
+    auto ready = std::transform_reduce(
+        preds.begin(),
+        preds.end(),
+        0,
+        [](const auto lhs, const auto rhs) { return std::max(lhs, rhs); },
+        [&](const auto pred) { return S.t_f(pred); });
+
+    // Earliest finish time of the task under every configuration. Switching
+    // the configuration waits for all PEs and then for the reconfiguration,
+    // or only for the region of the PE with partial reconfiguration.
+    size_t best     = nc;
+    PE     best_pe(0);
+    int    best_t_s = 0;
+    int    best_t_f = std::numeric_limits<int>::max();
+    for (size_t c = 0; c < nc; c++) {
+      if (not T.supports(task, c)) {
+        continue;
+      }
+      const int earliest =
+          std::max(
+              ready,
+              c == current ? last_reconfig
+                           : S.makespan() + R.cost(current, c)) +
+          1;
+      if (reconfiguration == Reconfiguration::Partial ||
+          placement == Placement::Insertion) {
+        auto gap = reconfiguration == Reconfiguration::Partial
+                       ? S.earliest_region(R, c, task, ready + 1)
+                       : S.earliest_gap(C[c], task, earliest);
+        const int t_f = gap.second + W.cost(task, gap.first);
+        // Stay in the current configuration unless switching is faster
+        if (t_f < best_t_f || (t_f == best_t_f && c == current)) {
+          best     = c;
+          best_pe  = gap.first;
+          best_t_s = gap.second;
+          best_t_f = t_f;
+        }
+        continue;
+      }
+      for (const auto &pe : C[c].pes) {
+        const int cost = W.cost(task, pe);
+        if (cost == CostMatrix::Unsupported) {
+          continue;
+        }
+        const int t_s = std::max(earliest, S.max_t_f(pe) + 1);
+        if (t_s + cost < best_t_f || (t_s + cost == best_t_f && c == current)) {
+          best     = c;
+          best_pe  = pe;
+          best_t_s = t_s;
+          best_t_f = t_s + cost;
+        }
+      }
+    }
+    assert(best != nc);
+
+    if (reconfiguration == Reconfiguration::Partial) {
+      S.schedule_on_region(R, task, best_pe, best_t_s);
+    }
+    else {
+      if (best != current) {
+        last_reconfig = S.insert_reconfiguration(R.cost(current, best));
+      }
+      S.schedule_task(task, best_pe, best_t_s);
+    }
+    current = best;
+
+    for (auto succ : g.succs(task)) {
+      if (--waiting[succ] == 0) {
+        ready_list.push_back(succ);
+        std::push_heap(ready_list.begin(), ready_list.end(), lower_priority);
+      }
+    }
+  }
+
+  return S;
+}
+
+size_t run_memory(const DAG &g, const CostMatrix &W, const Configurations &C)
+{
+  const size_t n = g.ntasks();
+
+  // Schedule
+  size_t bytes = n * sizeof(Schedule::ScheduledTask) + n * sizeof(int);
+  bytes += W.npes() * (2 * sizeof(int) + sizeof(size_t));
+  bytes += W.npes() * sizeof(std::pmr::vector<size_t>);
+  // The per-PE timelines and reconfigurations grow by doubling and the arena
+  // never frees the old storage
+  bytes += 2 * n * sizeof(size_t) + 2 * n * sizeof(int);
+  // Regions, and the durations and regions of the reconfigurations, at most
+  // one per task
+  bytes += W.npes() * (2 * sizeof(size_t) + sizeof(int));
+  bytes += 2 * n * (sizeof(size_t) + sizeof(int));
+  // Idle intervals, at most two nodes per task
+  bytes += W.npes() * sizeof(IdleIntervals) + 2 * n * 64;
+
+  // Clustering and its segmentation
+  bytes += n * sizeof(Vertex) + n * sizeof(Cluster);
+  bytes += C.size() * (n + 1) * (sizeof(int64_t) + 2 * sizeof(size_t));
+  bytes += C.size() * (sizeof(int64_t) + 2 * sizeof(size_t));
+  bytes += C.size() * (n + 1) * (sizeof(int64_t) + sizeof(uint32_t));
+
+  // Priority order and heft: ranks, costs, levels, positions, predecessor
+  // counts and ready lists
+  bytes += 3 * n * sizeof(Vertex) + 2 * n * sizeof(int64_t);
+  bytes += 3 * n * sizeof(size_t) + n * sizeof(uint32_t) + n / 8;
+  bytes += C.size() * (sizeof(std::pmr::vector<Vertex>) + 2 * n * sizeof(Vertex));
+
+  // lsl scratch
+  bytes += C.size() * sizeof(std::optional<int>);
+  bytes += C.size() * C.size() * (sizeof(int64_t) + sizeof(int32_t));
+  if (C.size() >= ParallelLookahead) {
+    bytes += (1 << 18) * (sizeof(int64_t) + sizeof(int32_t));
+  }
+
+  // Alignment and bookkeeping of the arena
+  return bytes + bytes / 8 + 4096;
+}
+
+Clustering::Clustering(
+    const DAG                 &g,
+    Cluster::order             o,
+    const ConfigCosts         &costs,
+    const ReconfigCosts       &reconfig_costs,
+    const Configurations      &configs,
+    std::pmr::memory_resource *mem)
+  : graph(std::addressof(g))
+  , order(std::move(o), mem)
+  , clusters(mem)
+  , C(std::addressof(configs))
+  , T(std::addressof(costs))
+  , R(std::addressof(reconfig_costs))
+  , prefix_cost(configs.size() * (order.size() + 1), 0, mem)
+  , prefix_unsupported(configs.size() * (order.size() + 1), 0, mem)
+{
+  // Prefix sums of the divided cost over the order for each configuration.
+  // Tasks a configuration does not support are counted instead.
+  const size_t n = order.size();
+  for (size_t c = 0; c < C->size(); c++) {
+    const size_t row = c * (n + 1);
+    for (size_t k = 0; k < n; k++) {
+      const int cost = T->divided_cost(order[k], c);
+      prefix_cost[row + k + 1] = prefix_cost[row + k];
+      prefix_unsupported[row + k + 1] = prefix_unsupported[row + k];
+      if (cost == CostMatrix::Unsupported) {
+        prefix_unsupported[row + k + 1]++;
+      }
+      else {
+        prefix_cost[row + k + 1] += cost;
+      }
+    }
+  }
+
+  clusters.reserve(order.size());
   for (auto it = order.begin(); it != order.end(); it++) {
     Cluster new_cluster(it, it + 1);
     auto    best_config = opt_cluster_cost(new_cluster);
@@ -206,34 +566,33 @@ bool Cluster::is_empty() const
 }
 
 std::optional<int> Clustering::cluster_cost(
-    const Configuration &c, const Cluster &cluster) const
+    size_t c, const Cluster &cluster) const
 {
   assert(std::distance(cluster.front, cluster.back) >= 1);
-  return std::transform_reduce(
-      cluster.front,
-      cluster.back,
-      std::optional<int>(0),
-      [&](auto v, auto acc) {
-        if (v && acc) {
-          return std::optional<int>(v.value() + acc.value());
-        }
-        else {
-          return std::optional<int>();
-        }
-      },
-      [&](auto v) {
-        auto &task = graph[boost::vertex(v, graph)];
-        return c.divided_cost(task);
-      });
+  const size_t row   = c * (order.size() + 1);
+  const size_t front = row + std::distance(order.cbegin(), cluster.front);
+  const size_t back  = row + std::distance(order.cbegin(), cluster.back);
+
+  if (prefix_unsupported[back] != prefix_unsupported[front]) {
+    return std::optional<int>();
+  }
+  return std::optional<int>(
+      static_cast<int>(prefix_cost[back] - prefix_cost[front]));
+}
+
+size_t Clustering::config_index(const Cluster &cluster) const
+{
+  assert(cluster.config);
+  return std::distance(C->data(), cluster.config);
 }
 
 std::pair<Configurations::const_iterator, int> Clustering::opt_cluster_cost(
     const Cluster &cluster) const
 {
-  auto config = C.end();
+  auto config = C->end();
   int  cost   = INT_MAX;
-  for (auto it = C.begin(); it != C.end(); ++it) {
-    auto c_cost = cluster_cost(*it, cluster);
+  for (auto it = C->begin(); it != C->end(); ++it) {
+    auto c_cost = cluster_cost(std::distance(C->begin(), it), cluster);
     if (c_cost && c_cost.value() < cost) {
       cost   = c_cost.value();
       config = it;
@@ -245,22 +604,26 @@ std::pair<Configurations::const_iterator, int> Clustering::opt_cluster_cost(
 bool Clustering::merge()
 {
   bool done = true;
-  for (auto lhs = clusters.begin(), rhs = clusters.begin() + 1;
-       rhs != clusters.end();
-       ++lhs, ++rhs) {
-    // TODO: consider case where empty clusters hinder merging
-    //
-    // This should simple skip rhs until there is one
-    while(rhs != clusters.end() && rhs->is_empty()) {
-      rhs++;
-    }
-    if (lhs->is_empty() || rhs->is_empty()) {
-      continue;
+  auto lhs  = std::find_if_not(clusters.begin(), clusters.end(), [](auto &c) {
+    return c.is_empty();
+  });
+  while (lhs != clusters.end()) {
+    // Compare with the next non-empty cluster, merged clusters are left
+    // behind as empty ones
+    auto rhs = std::find_if_not(std::next(lhs), clusters.end(), [](auto &c) {
+      return c.is_empty();
+    });
+    if (rhs == clusters.end()) {
+      break;
     }
     auto combined      = lhs->expand(*rhs);
     auto combined_conf = opt_cluster_cost(combined);
-    auto separate_cost = lhs->cost + rhs->cost + rho;
-    if (combined_conf.second < separate_cost) {
+    // Merging saves the reconfiguration between both clusters. Clusters of
+    // the same configuration need none and are always merged.
+    auto separate_cost =
+        lhs->cost + rhs->cost +
+        R->cost(config_index(*lhs), config_index(*rhs));
+    if (combined_conf.second < separate_cost || lhs->config == rhs->config) {
       rhs->cost   = combined_conf.second;
       rhs->config = std::addressof(*combined_conf.first);
       rhs->front  = combined.front;
@@ -268,10 +631,101 @@ bool Clustering::merge()
       lhs->empty();
       done = false;
     }
+    lhs = rhs;
   }
   return done;
 }
 
+// Replace the clusters by a segmentation of order into contiguous clusters
+// which minimizes the sum of the cluster costs plus the reconfigurations into
+// each cluster, i.e. the criterion merge() greedily optimizes.
+//
+// With F_c[j] the optimal cost of the first j tasks where the last cluster
+// uses configuration c and P_c the prefix sums of c,
+//
+//   F_c[j] = P_c[j] + min_i (E_c[i] - P_c[i])
+//   E_c[i] = min_{c' != c} F_c'[i] + R(c', c)   (R(none, c) for i = 0)
+//
+// over all i < j such that c supports the tasks [i, j). The inner minimum only
+// grows by one candidate per step and is reset by unsupported tasks, so it is
+// kept as a running minimum per configuration and the whole DP takes
+// O(N*C^2) for the C^2 reconfiguration costs per step.
+void Clustering::segment()
+{
+  constexpr int64_t Infeasible = std::numeric_limits<int64_t>::max();
+
+  auto        *mem = clusters.get_allocator().resource();
+  const size_t n   = order.size();
+  const size_t nc  = C->size();
+
+  // F and the start i and previous configuration c' it was reached from, the
+  // entry for (j, c) at j * nc + c
+  std::pmr::vector<int64_t> F((n + 1) * nc, Infeasible, mem);
+  std::pmr::vector<size_t>  from((n + 1) * nc, 0, mem);
+  std::pmr::vector<size_t>  previous((n + 1) * nc, nc, mem);
+  // Running minimum of E_c[i] - P_c[i] and the i and c' it was reached at
+  std::pmr::vector<int64_t> min_start(nc, Infeasible, mem);
+  std::pmr::vector<size_t>  arg_start(nc, 0, mem);
+  std::pmr::vector<size_t>  arg_previous(nc, nc, mem);
+
+  for (size_t j = 1; j <= n; j++) {
+    const size_t i = j - 1;
+    for (size_t c = 0; c < nc; c++) {
+      const size_t row = c * (n + 1);
+      if (prefix_unsupported[row + j] != prefix_unsupported[row + i]) {
+        min_start[c] = Infeasible;
+        continue;
+      }
+
+      // E_c[i], entering c after the first i tasks
+      int64_t entry      = i == 0 ? R->cost(nc, c) : Infeasible;
+      size_t  entry_from = nc;
+      for (size_t p = 0; p < nc && i > 0; p++) {
+        if (p == c || F[i * nc + p] == Infeasible) {
+          continue;
+        }
+        const int64_t cost = F[i * nc + p] + R->cost(p, c);
+        if (cost < entry) {
+          entry      = cost;
+          entry_from = p;
+        }
+      }
+      if (entry != Infeasible) {
+        const int64_t start = entry - prefix_cost[row + i];
+        if (min_start[c] == Infeasible || start < min_start[c]) {
+          min_start[c]    = start;
+          arg_start[c]    = i;
+          arg_previous[c] = entry_from;
+        }
+      }
+      if (min_start[c] == Infeasible) {
+        continue;
+      }
+      F[j * nc + c]        = min_start[c] + prefix_cost[row + j];
+      from[j * nc + c]     = arg_start[c];
+      previous[j * nc + c] = arg_previous[c];
+    }
+  }
+
+  // Walk the segmentation back to front. merge() leaves the empty clusters
+  // in place, but they carry no information, so only the segments are kept.
+  const auto last = std::min_element(F.begin() + n * nc, F.end());
+  assert(*last != Infeasible);
+  clusters.clear();
+  for (size_t j = n, c = std::distance(F.begin() + n * nc, last); j > 0;) {
+    const size_t i   = from[j * nc + c];
+    const size_t row = c * (n + 1);
+    clusters.emplace_back(
+        order.cbegin() + i,
+        order.cbegin() + j,
+        (*C)[c],
+        static_cast<int>(prefix_cost[row + j] - prefix_cost[row + i]));
+    c = previous[j * nc + c];
+    j = i;
+  }
+  std::reverse(clusters.begin(), clusters.end());
+}
+
 std::ostream &operator<<(std::ostream &os, const Cluster &c)
 {
   if (!c.is_empty()) {
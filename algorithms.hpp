@@ -1,17 +1,93 @@
 #pragma once
 
 #include <stddef.h>
+#include <cstdint>
+#include <memory_resource>
 
+#include "dag.hpp"
+#include "ordering.hpp"
 #include "scheduling.hpp"
+#include "thread_pool.hpp"
 
-extern int rho;
+// Minimum number of configurations for which lsl() scores the configurations
+// on the thread pool. Below, the synchronization costs more than it saves.
+constexpr size_t ParallelLookahead = 16;
 
-Schedule lsl(const Graph &g, const Configurations &C, size_t L);
-Schedule cluster(Graph &g, Configurations &C);
+Schedule lsl(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    size_t                     L,
+    Placement                  placement       = Placement::Append,
+    Ordering                   ordering        = Ordering::Topological,
+    Reconfiguration            reconfiguration = Reconfiguration::Global,
+    std::pmr::memory_resource *mem  = std::pmr::get_default_resource(),
+    ThreadPool                *pool = nullptr);
+// lsl() on the given topological order of g
+Schedule lsl(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    const Order               &order,
+    size_t                     L,
+    Placement                  placement       = Placement::Append,
+    Reconfiguration            reconfiguration = Reconfiguration::Global,
+    std::pmr::memory_resource *mem  = std::pmr::get_default_resource(),
+    ThreadPool                *pool = nullptr);
+
+// How cluster() partitions the order into clusters: by greedily merging
+// adjacent clusters, or by an exact dynamic program over all partitions.
+enum class Segmentation { Greedy, Optimal };
+
+Schedule cluster(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    Placement                  placement       = Placement::Append,
+    Segmentation               segmentation    = Segmentation::Greedy,
+    Ordering                   ordering        = Ordering::Topological,
+    Reconfiguration            reconfiguration = Reconfiguration::Global,
+    std::pmr::memory_resource *mem = std::pmr::get_default_resource());
+
+// cluster() on the given topological order of g
+Schedule cluster(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    const Order               &order,
+    Placement                  placement       = Placement::Append,
+    Segmentation               segmentation    = Segmentation::Greedy,
+    Reconfiguration            reconfiguration = Reconfiguration::Global,
+    std::pmr::memory_resource *mem = std::pmr::get_default_resource());
+
+// List scheduler in the style of HEFT: tasks are taken from a ready list by
+// their upward rank and placed on the configuration and PE which finish them
+// earliest, including the reconfiguration if the configuration is switched
+Schedule heft(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    Placement                  placement       = Placement::Append,
+    Reconfiguration            reconfiguration = Reconfiguration::Global,
+    std::pmr::memory_resource *mem = std::pmr::get_default_resource());
+
+// Upper estimate of the memory a single lsl(), cluster() or heft() run
+// allocates from mem, used to size a per-run Arena
+size_t run_memory(const DAG &g, const CostMatrix &W, const Configurations &C);
 
 
 struct Cluster {
-  using order   = std::vector<Vertex>;
+  using order   = std::pmr::vector<Vertex>;
   using OrderIt = order::const_iterator;
 
   OrderIt              front;
@@ -30,16 +106,31 @@ struct Cluster {
 };
 
 struct Clustering {
-  Graph               graph;
-  std::vector<Vertex> order;
-  std::vector<Cluster> clusters;
-  Configurations       C;
+  DAG const                 *graph = nullptr;
+  Cluster::order             order;
+  std::pmr::vector<Cluster>  clusters;
+  Configurations const      *C = nullptr;
+  ConfigCosts const         *T = nullptr;
+  ReconfigCosts const       *R = nullptr;
+  // Per configuration prefix sums over order of the divided cost and of the
+  // number of unsupported tasks, so cluster costs are O(1). The row of
+  // configuration c starts at c * (order.size() + 1).
+  std::pmr::vector<int64_t>  prefix_cost;
+  std::pmr::vector<uint32_t> prefix_unsupported;
 
-  Clustering(Graph &&g, const Configurations &configs);
+  // Clusters the tasks in the topological order o of g
+  Clustering(
+      const DAG                 &g,
+      Cluster::order             o,
+      const ConfigCosts         &costs,
+      const ReconfigCosts       &reconfig_costs,
+      const Configurations      &configs,
+      std::pmr::memory_resource *mem = std::pmr::get_default_resource());
 
-  std::optional<int> cluster_cost(
-      const Configuration &, const Cluster &) const;
+  std::optional<int> cluster_cost(size_t c, const Cluster &) const;
+  size_t             config_index(const Cluster &) const;
   std::pair<Configurations::const_iterator, int> opt_cluster_cost(
       const Cluster &) const;
   bool merge();
+  void segment();
 };
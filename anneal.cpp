@@ -0,0 +1,72 @@
+#include <fstream>
+#include <iostream>
+
+#include "algorithms.hpp"
+#include "annealing.hpp"
+#include "scheduling.hpp"
+#include "util.hpp"
+
+int main(int argc, char **argv)
+{
+  int         rho          = 2;
+  auto        budget       = std::chrono::milliseconds(1000);
+  uint64_t    seed         = 1;
+  std::string segmentation = "greedy";
+  if (argc < 2) {
+    std::cout << "No input file given. Usage:" << std::endl
+              << std::endl
+              << "    anneal <inputjson>.json [rho] [budget ms] [seed] "
+                 "[greedy|optimal]"
+              << std::endl;
+    return 1;
+  }
+
+  std::filesystem::path json_path(argv[1]);
+  if (argc >= 3) {
+    rho = atoi(argv[2]);
+  }
+  if (argc >= 4) {
+    budget = std::chrono::milliseconds(std::max(0, atoi(argv[3])));
+  }
+  if (argc >= 5) {
+    seed = std::strtoull(argv[4], nullptr, 10);
+  }
+  if (argc >= 6) {
+    segmentation = argv[5];
+  }
+
+  // Import
+  std::ifstream  i(json_path);
+  nlohmann::json j;
+  i >> j;
+  const DAG           D(import_task_graph(j));
+  const auto          W = import_costs(j);
+  const auto          C = import_configs(j);
+  const ConfigCosts   T(W, C);
+  const ReconfigCosts R = import_reconfig_costs(j, C.size(), rho);
+
+  AnnealStats stats;
+  auto        start = std::chrono::high_resolution_clock::now();
+  auto        s     = anneal(
+      D,
+      W,
+      C,
+      T,
+      R,
+      budget,
+      seed,
+      segmentation == "optimal" ? Segmentation::Optimal : Segmentation::Greedy,
+      Ordering::Topological,
+      &stats);
+  auto end = std::chrono::high_resolution_clock::now();
+
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+  std::cout << "anneal," << rho << "," << D.ntasks() << "," << s.makespan()
+            << "," << us.count() << "," << s.reconfigs.size() << ","
+            << stats.initial_makespan << "," << stats.iterations << std::endl;
+
+  json_path.replace_extension("svg");
+  export_svg(s, D, json_path.filename());
+
+  return 0;
+}
@@ -0,0 +1,512 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "annealing.hpp"
+
+namespace {
+
+constexpr size_t NoPE = std::numeric_limits<size_t>::max();
+
+// Scheduling state before a segment, as cluster() has it
+struct Checkpoint {
+  std::vector<int> pe_t_f;
+  int              max_t_f      = 0;
+  int              reconfig_end = 0;
+  size_t           config;
+
+  bool operator==(const Checkpoint &other) const
+  {
+    return max_t_f == other.max_t_f && reconfig_end == other.reconfig_end &&
+           config == other.config && pe_t_f == other.pe_t_f;
+  }
+};
+
+enum class MoveKind { Shift, Config, Split, Merge, Pin };
+
+// A change of the segmentation and what is needed to undo it. Shift moves
+// the start of segment s to position, Config and Split give segment s
+// respectively a new part from position on the configuration config, Merge
+// joins segments s and s + 1 on config, Pin pins position to the PE pe.
+struct Move {
+  MoveKind kind;
+  size_t   s;
+  size_t   position = 0;
+  size_t   config   = 0;
+  size_t   pe       = 0;
+
+  // The first segment to re-simulate, and whether the segments from it
+  // correspond to the ones before the move
+  size_t first      = 0;
+  bool   same_shape = true;
+  // Replaced start, configurations and PE
+  size_t old_start       = 0;
+  size_t old_config      = 0;
+  size_t old_next_config = 0;
+  size_t old_pe          = 0;
+};
+
+// A segmentation of the order into clusters with one configuration each and
+// optionally pinned PEs, and its incremental evaluation. Segment s covers the
+// positions [starts[s], starts[s + 1]) of the order.
+class Segments {
+  public:
+  Segments(
+      const DAG            &graph,
+      const CostMatrix     &costs,
+      const Configurations &configurations,
+      const ReconfigCosts  &reconfig_costs,
+      const Clustering     &clustered)
+    : g(graph)
+    , W(costs)
+    , C(configurations)
+    , R(reconfig_costs)
+    , clustering(clustered)
+    , order(clustering.order)
+    , pe_choice(order.size(), NoPE)
+    , t_f(g.ntasks(), 0)
+    , last_succ(g.ntasks(), 0)
+  {
+    std::vector<size_t> position(g.ntasks());
+    for (size_t p = 0; p < order.size(); p++) {
+      position[order[p]] = p;
+    }
+    for (size_t p = 0; p < order.size(); p++) {
+      for (auto succ : g.succs(order[p])) {
+        last_succ[order[p]] = std::max(last_succ[order[p]], position[succ] + 1);
+      }
+    }
+    for (const auto &cluster : clustering.clusters) {
+      if (not cluster.is_empty()) {
+        starts.push_back(std::distance(order.cbegin(), cluster.front));
+        configs.push_back(clustering.config_index(cluster));
+      }
+    }
+    Checkpoint initial;
+    initial.pe_t_f.assign(W.npes(), 0);
+    initial.config = C.size();
+    checkpoints.push_back(initial);
+    makespan = simulate(0, false);
+    commit(0);
+  }
+
+  // Applies m to the segmentation, unpinning the positions whose segment
+  // changes, and records what undo() needs
+  void apply(Move &m)
+  {
+    unpinned.clear();
+    m.first      = m.s;
+    m.same_shape = true;
+    switch (m.kind) {
+    case MoveKind::Shift:
+      m.old_start = starts[m.s];
+      unpin(std::min(m.position, m.old_start),
+            std::max(m.position, m.old_start));
+      starts[m.s]   = m.position;
+      m.first       = m.s - 1;
+      changed_until = m.s;
+      break;
+    case MoveKind::Config:
+      m.old_config = configs[m.s];
+      unpin(begin(m.s), end(m.s));
+      configs[m.s]  = m.config;
+      changed_until = m.s;
+      break;
+    case MoveKind::Split:
+      unpin(m.position, end(m.s));
+      starts.insert(starts.begin() + m.s + 1, m.position);
+      configs.insert(configs.begin() + m.s + 1, m.config);
+      m.same_shape = false;
+      break;
+    case MoveKind::Merge:
+      m.old_start       = starts[m.s + 1];
+      m.old_config      = configs[m.s];
+      m.old_next_config = configs[m.s + 1];
+      unpin(begin(m.s), end(m.s + 1));
+      starts.erase(starts.begin() + m.s + 1);
+      configs.erase(configs.begin() + m.s + 1);
+      configs[m.s] = m.config;
+      m.same_shape = false;
+      break;
+    case MoveKind::Pin:
+      m.old_pe              = pe_choice[m.position];
+      pe_choice[m.position] = m.pe;
+      changed_until         = m.s;
+      break;
+    }
+  }
+
+  // Reverts apply(m), leaving the simulation state alone
+  void undo(const Move &m)
+  {
+    switch (m.kind) {
+    case MoveKind::Shift:
+      starts[m.s] = m.old_start;
+      break;
+    case MoveKind::Config:
+      configs[m.s] = m.old_config;
+      break;
+    case MoveKind::Split:
+      starts.erase(starts.begin() + m.s + 1);
+      configs.erase(configs.begin() + m.s + 1);
+      break;
+    case MoveKind::Merge:
+      starts.insert(starts.begin() + m.s + 1, m.old_start);
+      configs.insert(configs.begin() + m.s + 1, m.old_next_config);
+      configs[m.s] = m.old_config;
+      break;
+    case MoveKind::Pin:
+      pe_choice[m.position] = m.old_pe;
+      break;
+    }
+    for (auto it = unpinned.rbegin(); it != unpinned.rend(); ++it) {
+      pe_choice[it->first] = it->second;
+    }
+  }
+
+  size_t nsegments() const { return starts.size(); }
+  size_t begin(size_t s) const { return starts[s]; }
+  size_t end(size_t s) const
+  {
+    return s + 1 < starts.size() ? starts[s + 1] : order.size();
+  }
+  size_t segment(size_t position) const
+  {
+    return std::distance(
+               starts.begin(),
+               std::upper_bound(starts.begin(), starts.end(), position)) -
+           1;
+  }
+  bool supports(size_t c, size_t first, size_t last) const
+  {
+    Cluster cluster(order.cbegin() + first, order.cbegin() + last);
+    return clustering.cluster_cost(c, cluster).has_value();
+  }
+
+  // Re-simulates the segments from s onwards and returns the makespan. With
+  // same_shape, the segments from s onwards correspond to the committed ones,
+  // and the simulation stops as soon as it reaches a committed state again.
+  int simulate(size_t s, bool same_shape)
+  {
+    state  = checkpoints[s];
+    nfresh = 0;
+    for (; s < nsegments(); s++) {
+      if (same_shape && s > changed_until && reach <= begin(s) &&
+          state == checkpoints[s]) {
+        return makespan;
+      }
+      keep(state);
+
+      const size_t c = configs[s];
+      if (c != state.config) {
+        state.reconfig_end = state.max_t_f + R.cost(state.config, c);
+        state.config       = c;
+      }
+      for (size_t p = begin(s); p < end(s); p++) {
+        const Vertex v     = order[p];
+        int          ready = state.reconfig_end;
+        for (auto pred : g.preds(v)) {
+          ready = std::max(ready, t_f[pred]);
+        }
+
+        // The earliest PE as Schedule::asap() chooses it, unless pinned
+        PE  pe(pe_choice[p]);
+        int cost = pe_choice[p] != NoPE ? W.cost(v, pe) : 0;
+        if (pe_choice[p] == NoPE) {
+          int min_t_f = std::numeric_limits<int>::max();
+          for (const auto &candidate : C[c].pes) {
+            const int candidate_cost = W.cost(v, candidate);
+            if (candidate_cost != CostMatrix::Unsupported &&
+                state.pe_t_f[candidate.offset] + candidate_cost < min_t_f) {
+              pe      = candidate;
+              cost    = candidate_cost;
+              min_t_f = state.pe_t_f[candidate.offset] + candidate_cost;
+            }
+          }
+        }
+        assert(cost != CostMatrix::Unsupported);
+
+        const int t_s = std::max(state.pe_t_f[pe.offset], ready) + 1;
+        if (t_f[v] != t_s + cost) {
+          log.emplace_back(v, t_f[v]);
+          reach  = std::max(reach, last_succ[v]);
+          t_f[v] = t_s + cost;
+        }
+        state.pe_t_f[pe.offset] = std::max(state.pe_t_f[pe.offset], t_f[v]);
+        state.max_t_f           = std::max(state.max_t_f, t_f[v]);
+      }
+    }
+    keep(state);
+    return state.max_t_f;
+  }
+
+  // Keep the simulated checkpoints from segment s onwards. The checkpoints
+  // beyond the last segment are spare, so their buffers are reused.
+  void commit(size_t s)
+  {
+    if (checkpoints.size() < nsegments() + 1) {
+      checkpoints.resize(nsegments() + 1, checkpoints.front());
+    }
+    std::copy(fresh.begin(), fresh.begin() + nfresh, checkpoints.begin() + s);
+    log.clear();
+    reach = 0;
+  }
+
+  // Restore the finish times of the last simulation
+  void rollback()
+  {
+    for (auto it = log.rbegin(); it != log.rend(); ++it) {
+      t_f[it->first] = it->second;
+    }
+    log.clear();
+    reach = 0;
+  }
+
+  const DAG            &g;
+  const CostMatrix     &W;
+  const Configurations &C;
+  const ReconfigCosts  &R;
+  const Clustering     &clustering;
+  const Order          &order;
+  std::vector<size_t>   starts;
+  std::vector<size_t>   configs;
+  std::vector<size_t>   pe_choice;
+  int                   makespan = 0;
+  // Last segment a move changed, for the early exit of simulate()
+  size_t                changed_until = 0;
+
+  private:
+  void unpin(size_t from, size_t to)
+  {
+    for (size_t p = from; p < to; p++) {
+      if (pe_choice[p] != NoPE) {
+        unpinned.emplace_back(p, pe_choice[p]);
+        pe_choice[p] = NoPE;
+      }
+    }
+  }
+
+  // Appends a checkpoint to the ones of the last simulation
+  void keep(const Checkpoint &checkpoint)
+  {
+    if (nfresh < fresh.size()) {
+      fresh[nfresh] = checkpoint;
+    }
+    else {
+      fresh.push_back(checkpoint);
+    }
+    nfresh++;
+  }
+
+  std::vector<int>                    t_f;
+  std::vector<Checkpoint>             checkpoints;
+  std::vector<Checkpoint>             fresh;
+  size_t                              nfresh = 0;
+  Checkpoint                          state;
+  // Pins removed by the last apply()
+  std::vector<std::pair<size_t, size_t>> unpinned;
+  std::vector<std::pair<Vertex, int>> log;
+  // Last position of a successor of a task whose finish time changed since
+  // the last commit
+  size_t                              reach = 0;
+  std::vector<size_t>                 last_succ;
+};
+
+} // namespace
+
+Schedule anneal(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    std::chrono::milliseconds  budget,
+    uint64_t                   seed,
+    Segmentation               segmentation,
+    Ordering                   ordering,
+    AnnealStats               *stats,
+    std::pmr::memory_resource *mem)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  Clustering clustering(g, priority_order(g, T, ordering, mem), T, R, C, mem);
+  if (segmentation == Segmentation::Optimal) {
+    clustering.segment();
+  }
+  else {
+    while (not clustering.merge()) {
+    }
+  }
+
+  Segments    current(g, W, C, R, clustering);
+  auto        best_starts    = current.starts;
+  auto        best_configs   = current.configs;
+  auto        best_pe_choice = current.pe_choice;
+  int         best           = current.makespan;
+  // Whether the best segmentation is the current one and not saved yet
+  bool        unsaved        = false;
+  AnnealStats local;
+  local.initial_makespan = current.makespan;
+
+  auto save = [&]() {
+    best_starts.assign(current.starts.begin(), current.starts.end());
+    best_configs.assign(current.configs.begin(), current.configs.end());
+    best_pe_choice.assign(current.pe_choice.begin(), current.pe_choice.end());
+  };
+
+  std::mt19937_64 random(seed);
+  auto            uniform = [&](size_t n) {
+    return std::uniform_int_distribution<size_t>(0, n - 1)(random);
+  };
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+  // The temperature falls linearly over the budget from a small fraction of
+  // the initial makespan to zero
+  const double initial_temperature = 0.01 * current.makespan;
+  const size_t n                   = current.order.size();
+
+  while (n > 0) {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed >= budget) {
+      break;
+    }
+    const double temperature =
+        initial_temperature *
+        (1.0 - std::chrono::duration<double>(elapsed) /
+                   std::chrono::duration<double>(budget));
+    local.iterations++;
+
+    // Draw a random move and skip it unless it is valid
+    Move         move{MoveKind::Shift, 0};
+    const size_t ns   = current.nsegments();
+    const size_t kind = uniform(5);
+    if (kind == 0 && ns > 1) {
+      // Shift the boundary between segments s - 1 and s
+      const size_t s  = 1 + uniform(ns - 1);
+      const size_t lo = current.begin(s - 1) + 1;
+      const size_t hi = current.end(s) - 1;
+      if (lo > hi) {
+        continue;
+      }
+      const size_t moved = lo + uniform(hi - lo + 1);
+      if (moved == current.begin(s) ||
+          not current.supports(current.configs[s - 1], lo - 1, moved) ||
+          not current.supports(current.configs[s], moved, hi + 1)) {
+        continue;
+      }
+      move = Move{MoveKind::Shift, s, moved};
+    }
+    else if (kind == 1) {
+      // Change the configuration of segment s
+      const size_t s = uniform(ns);
+      const size_t c = uniform(C.size());
+      if (c == current.configs[s] ||
+          not current.supports(c, current.begin(s), current.end(s))) {
+        continue;
+      }
+      move = Move{MoveKind::Config, s, 0, c};
+    }
+    else if (kind == 2) {
+      // Split segment s, the second part takes a random configuration
+      const size_t s = uniform(ns);
+      if (current.end(s) - current.begin(s) < 2) {
+        continue;
+      }
+      const size_t cut = current.begin(s) + 1 +
+                         uniform(current.end(s) - current.begin(s) - 1);
+      const size_t c = uniform(C.size());
+      if (not current.supports(c, cut, current.end(s))) {
+        continue;
+      }
+      move = Move{MoveKind::Split, s, cut, c};
+    }
+    else if (kind == 3 && ns > 1) {
+      // Merge segments s and s + 1 into the configuration of either
+      const size_t s = uniform(ns - 1);
+      const size_t c = current.configs[s + uniform(2)];
+      if (not current.supports(c, current.begin(s), current.end(s + 1))) {
+        continue;
+      }
+      move = Move{MoveKind::Merge, s, 0, c};
+    }
+    else if (kind == 4) {
+      // Pin a task to a PE of its segment's configuration
+      const size_t p   = uniform(n);
+      const size_t s   = current.segment(p);
+      const auto  &pes = C[current.configs[s]].pes;
+      const PE     pe  = pes[uniform(pes.size())];
+      if (not W.supports(current.order[p], pe) ||
+          current.pe_choice[p] == pe.offset) {
+        continue;
+      }
+      move = Move{MoveKind::Pin, s, p, 0, pe.offset};
+    }
+    else {
+      continue;
+    }
+
+    current.apply(move);
+    const int  candidate = current.simulate(move.first, move.same_shape);
+    const int  delta     = candidate - current.makespan;
+    const bool accept =
+        delta <= 0 ||
+        (temperature > 0 && unit(random) < std::exp(-delta / temperature));
+    if (not accept) {
+      current.rollback();
+      current.undo(move);
+      continue;
+    }
+
+    current.commit(move.first);
+    current.makespan = candidate;
+    local.accepted++;
+    if (candidate < best) {
+      best    = candidate;
+      unsaved = true;
+      local.improvements++;
+    }
+    else if (unsaved && candidate > best) {
+      // Save the best segmentation before leaving it
+      current.undo(move);
+      save();
+      current.apply(move);
+      unsaved = false;
+    }
+  }
+  if (unsaved) {
+    save();
+  }
+
+  // Build the schedule of the best segmentation as cluster() does
+  Schedule S(C, W, Placement::Append, mem);
+  int      last_reconfig = 0;
+  size_t   last_config   = C.size();
+  for (size_t s = 0; s < best_starts.size(); s++) {
+    const size_t c = best_configs[s];
+    if (c != last_config) {
+      last_reconfig = S.insert_reconfiguration(R.cost(last_config, c));
+      last_config   = c;
+    }
+    const size_t end =
+        s + 1 < best_starts.size() ? best_starts[s + 1] : current.order.size();
+    for (size_t p = best_starts[s]; p < end; p++) {
+      const Vertex v     = current.order[p];
+      int          ready = last_reconfig;
+      for (auto pred : g.preds(v)) {
+        ready = std::max(ready, S.t_f(pred));
+      }
+      PE pe = best_pe_choice[p] != NoPE ? PE(best_pe_choice[p])
+                                        : S.asap(C[c], v).first;
+      S.schedule_task(v, pe, std::max(S.max_t_f(pe), ready) + 1);
+    }
+  }
+  assert(S.makespan() == best);
+
+  if (stats) {
+    *stats = local;
+  }
+  return S;
+}
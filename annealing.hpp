@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+
+#include "algorithms.hpp"
+#include "dag.hpp"
+#include "ordering.hpp"
+#include "scheduling.hpp"
+
+struct AnnealStats {
+  int    initial_makespan = 0;
+  size_t iterations       = 0;
+  size_t accepted         = 0;
+  size_t improvements     = 0;
+};
+
+// Improves the clusters of cluster() by simulated annealing for the given
+// time budget. Moves shift the boundary between two clusters, change the
+// configuration of a cluster, split or merge clusters, or pin a task to a
+// PE of its cluster's configuration. Schedules are evaluated as cluster()
+// builds them with Placement::Append and Reconfiguration::Global, and only
+// from the first cluster a move changes onwards.
+Schedule anneal(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    std::chrono::milliseconds  budget,
+    uint64_t                   seed         = 1,
+    Segmentation               segmentation = Segmentation::Greedy,
+    Ordering                   ordering     = Ordering::Topological,
+    AnnealStats               *stats        = nullptr,
+    std::pmr::memory_resource *mem = std::pmr::get_default_resource());
@@ -0,0 +1,79 @@
+#include <algorithm>
+
+#include "arena.hpp"
+
+CountingResource::CountingResource(std::pmr::memory_resource *u)
+  : upstream(u)
+{
+}
+
+size_t CountingResource::allocations() const
+{
+  return _allocations;
+}
+
+size_t CountingResource::bytes() const
+{
+  return _bytes;
+}
+
+void CountingResource::reset_counters()
+{
+  _allocations = 0;
+  _bytes       = 0;
+}
+
+void *CountingResource::do_allocate(size_t bytes, size_t alignment)
+{
+  _allocations++;
+  _bytes += bytes;
+  return upstream->allocate(bytes, alignment);
+}
+
+void CountingResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+  upstream->deallocate(p, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept
+{
+  return this == &other;
+}
+
+Arena::Arena(size_t bytes)
+  : buffer(std::max<size_t>(bytes, 1))
+  , heap(std::pmr::new_delete_resource())
+  , monotonic(buffer.data(), buffer.size(), &heap)
+  , counter(&monotonic)
+{
+}
+
+std::pmr::memory_resource *Arena::resource()
+{
+  return &counter;
+}
+
+void Arena::reset()
+{
+  monotonic.release();
+  heap.reset_counters();
+  counter.reset_counters();
+}
+
+size_t Arena::capacity() const
+{
+  return buffer.size();
+}
+
+// Allocations served by the arena since the last reset
+size_t Arena::allocations() const
+{
+  return counter.allocations();
+}
+
+// Allocations since the last reset which did not fit into the buffer
+size_t Arena::heap_allocations() const
+{
+  return heap.allocations();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Memory resource which forwards to an upstream resource and counts the
+// allocations it hands out.
+class CountingResource : public std::pmr::memory_resource {
+  public:
+  explicit CountingResource(
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+
+  size_t allocations() const;
+  size_t bytes() const;
+  void   reset_counters();
+
+  private:
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void  do_deallocate(void *p, size_t bytes, size_t alignment) override;
+  bool  do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+  std::pmr::memory_resource *upstream;
+  size_t                     _allocations = 0;
+  size_t                     _bytes       = 0;
+};
+
+// Monotonic arena for the state of a single scheduling run. Allocations are
+// served from a buffer which is allocated once up front; memory is only
+// returned to the arena by reset(). Once the buffer is exhausted, allocations
+// fall back to the heap and are counted in heap_allocations().
+//
+// Everything allocated from the arena (e.g. a Schedule) has to be destroyed
+// before the arena is reset.
+class Arena {
+  public:
+  explicit Arena(size_t bytes);
+  Arena(const Arena &)            = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  std::pmr::memory_resource *resource();
+  void                       reset();
+  size_t                     capacity() const;
+  size_t                     allocations() const;
+  size_t                     heap_allocations() const;
+
+  private:
+  std::vector<std::byte>              buffer;
+  CountingResource                    heap;
+  std::pmr::monotonic_buffer_resource monotonic;
+  CountingResource                    counter;
+};
@@ -0,0 +1,66 @@
+#include <fstream>
+#include <iostream>
+
+#include "beam_search.hpp"
+#include "bounds.hpp"
+#include "scheduling.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+int main(int argc, char **argv)
+{
+  int      rho      = 2;
+  size_t   width    = 8;
+  size_t   threads  = 1;
+  Ordering ordering = Ordering::Topological;
+  if (argc < 2) {
+    std::cout << "No input file given. Usage:" << std::endl
+              << std::endl
+              << "    beam <inputjson>.json [rho] [width] [threads] "
+                 "[topological|critical-path|bottom-level|affinity|level]"
+              << std::endl;
+    return 1;
+  }
+
+  std::filesystem::path json_path(argv[1]);
+  if (argc >= 3) {
+    rho = atoi(argv[2]);
+  }
+  if (argc >= 4) {
+    width = std::max(1, atoi(argv[3]));
+  }
+  if (argc >= 5) {
+    threads = std::max(1, atoi(argv[4]));
+  }
+  if (argc >= 6) {
+    ordering = parse_ordering(argv[5]).value_or(Ordering::Topological);
+  }
+
+  // Import
+  std::ifstream  i(json_path);
+  nlohmann::json j;
+  i >> j;
+  const DAG           D(import_task_graph(j));
+  const auto          W = import_costs(j);
+  const auto          C = import_configs(j);
+  const ConfigCosts   T(W, C);
+  const ReconfigCosts R = import_reconfig_costs(j, C.size(), rho);
+  ThreadPool          pool(threads);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  auto s     = beam_search(
+      D, W, C, T, R, width, ordering, std::pmr::get_default_resource(), &pool);
+  auto end = std::chrono::high_resolution_clock::now();
+
+  const int lower_bound = lower_bounds(D, C, T, R).makespan();
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+  std::cout << "beam," << rho << "," << D.ntasks() << "," << s.makespan() << ","
+            << us.count() << "," << s.reconfigs.size() << "," << width << ","
+            << pool.size() << "," << lower_bound << ","
+            << gap(s.makespan(), lower_bound) << std::endl;
+
+  json_path.replace_extension("svg");
+  export_svg(s, D, json_path.filename());
+
+  return 0;
+}
@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "beam_search.hpp"
+
+namespace {
+
+constexpr size_t NoSlot = std::numeric_limits<size_t>::max();
+// Expansions are only spread over the pool for at least this many beams
+constexpr size_t ParallelWidth = 4;
+
+// Hash of a value at an index of a frontier, summed into the frontier's key
+uint64_t element_hash(size_t index, int64_t value)
+{
+  uint64_t x = (uint64_t(index) << 32) ^ uint64_t(value);
+  x          = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+  x          = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+  return x ^ (x >> 31);
+}
+
+// The state of a partial schedule needed to continue it: the finish times
+// of the PEs and of the scheduled tasks with successors left to schedule,
+// which are kept in the same slots for all beams.
+struct Frontier {
+  std::vector<int> pe_t_f;
+  std::vector<int> live_t_f;
+  int              max_t_f      = 0;
+  int              reconfig_end = 0;
+  size_t           config;
+  // Index of the last decision in the history
+  size_t           last = NoSlot;
+
+  bool operator==(const Frontier &other) const
+  {
+    return max_t_f == other.max_t_f && reconfig_end == other.reconfig_end &&
+           config == other.config && pe_t_f == other.pe_t_f &&
+           live_t_f == other.live_t_f;
+  }
+
+  // Sum of the element hashes of max_t_f, reconfig_end, config, pe_t_f and
+  // live_t_f in this order, which changes in O(1) with one element
+  uint64_t key = 0;
+
+  void set(size_t index, int64_t from, int64_t to)
+  {
+    key += element_hash(index, to) - element_hash(index, from);
+  }
+
+  void rehash()
+  {
+    key = element_hash(0, max_t_f) + element_hash(1, reconfig_end) +
+          element_hash(2, config);
+    for (size_t pe = 0; pe < pe_t_f.size(); pe++) {
+      key += element_hash(3 + pe, pe_t_f[pe]);
+    }
+    for (size_t i = 0; i < live_t_f.size(); i++) {
+      key += element_hash(3 + pe_t_f.size() + i, live_t_f[i]);
+    }
+  }
+};
+
+// Placing the next task of a beam on pe, after reconfiguring to config if it
+// differs from the beam's
+struct Candidate {
+  size_t beam;
+  size_t pe;
+  size_t config;
+  int    t_f;
+  int    max_t_f;
+  // Sum of the PE finish times, to prefer beams with more free PEs
+  int64_t load;
+
+  bool operator<(const Candidate &other) const
+  {
+    return std::tie(max_t_f, load, beam, pe) <
+           std::tie(other.max_t_f, other.load, other.beam, other.pe);
+  }
+};
+
+struct Decision {
+  size_t parent;
+  size_t pe;
+  size_t config;
+};
+
+} // namespace
+
+Schedule beam_search(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    size_t                     width,
+    Ordering                   ordering,
+    std::pmr::memory_resource *mem,
+    ThreadPool                *pool)
+{
+  return beam_search(
+      g, W, C, T, R, priority_order(g, T, ordering, mem), width, mem, pool);
+}
+
+Schedule beam_search(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    const Order               &order,
+    size_t                     width,
+    std::pmr::memory_resource *mem,
+    ThreadPool                *pool)
+{
+  width = std::max<size_t>(width, 1);
+
+  // Assign each task with successors a slot of the live finish times until
+  // its last successor is scheduled
+  std::vector<size_t> slot(g.ntasks(), NoSlot);
+  std::vector<size_t> last_use(g.ntasks(), 0);
+  for (size_t p = 0; p < order.size(); p++) {
+    for (auto pred : g.preds(order[p])) {
+      last_use[pred] = std::max(last_use[pred], p);
+    }
+  }
+  std::vector<size_t> free_slots;
+  size_t              nslots = 0;
+  for (size_t p = 0; p < order.size(); p++) {
+    for (auto pred : g.preds(order[p])) {
+      if (last_use[pred] == p && slot[pred] != NoSlot) {
+        free_slots.push_back(slot[pred]);
+      }
+    }
+    if (not g.succs(order[p]).empty()) {
+      if (free_slots.empty()) {
+        free_slots.push_back(nslots++);
+      }
+      slot[order[p]] = free_slots.back();
+      free_slots.pop_back();
+    }
+  }
+
+  Frontier initial;
+  initial.pe_t_f.assign(W.npes(), 0);
+  initial.live_t_f.assign(nslots, 0);
+  initial.config = C.size();
+  initial.rehash();
+
+  std::vector<Frontier>               beams{initial}, next;
+  std::vector<Decision>               history;
+  std::vector<std::vector<Candidate>> expansions;
+  std::vector<Candidate>              candidates;
+  std::vector<Frontier>               expanded;
+  // Open addressing table of the indices of next, at most half full
+  size_t                              table_size = 1;
+  while (table_size < 2 * width) {
+    table_size *= 2;
+  }
+  std::vector<size_t>                 table(table_size, NoSlot);
+  const bool parallel = pool && pool->size() > 1 && width >= ParallelWidth;
+
+  for (size_t p = 0; p < order.size(); p++) {
+    const Vertex v = order[p];
+
+    // Expand every beam by every configuration and PE for v
+    expansions.resize(beams.size());
+    auto expand = [&](size_t b) {
+      const Frontier &beam = beams[b];
+      auto           &out  = expansions[b];
+      out.clear();
+      int preds_t_f = 0;
+      for (auto pred : g.preds(v)) {
+        preds_t_f = std::max(preds_t_f, beam.live_t_f[slot[pred]]);
+      }
+      int64_t load = 0;
+      for (auto t : beam.pe_t_f) {
+        load += t;
+      }
+      for (size_t c = 0; c < C.size(); c++) {
+        if (not T.supports(v, c)) {
+          continue;
+        }
+        const int reconfig_end =
+            c == beam.config ? beam.reconfig_end
+                             : beam.max_t_f + R.cost(beam.config, c);
+        const int ready = std::max(preds_t_f, reconfig_end);
+        for (const auto &pe : C[c].pes) {
+          if (not W.supports(v, pe)) {
+            continue;
+          }
+          const int t_f = std::max(beam.pe_t_f[pe.offset], ready) + 1 +
+                          W.cost(v, pe);
+          out.push_back(Candidate{
+              b,
+              pe.offset,
+              c,
+              t_f,
+              std::max(beam.max_t_f, t_f),
+              load - beam.pe_t_f[pe.offset] +
+                  std::max(beam.pe_t_f[pe.offset], t_f)});
+        }
+      }
+    };
+    if (parallel) {
+      pool->parallel_for(0, beams.size(), expand);
+    }
+    else {
+      for (size_t b = 0; b < beams.size(); b++) {
+        expand(b);
+      }
+    }
+
+    // Keep the width best distinct expansions. Candidates are materialized
+    // in batches in order until enough distinct frontiers are found, and
+    // duplicates are found by hash in an open addressing table of next.
+    candidates.clear();
+    for (const auto &out : expansions) {
+      candidates.insert(candidates.end(), out.begin(), out.end());
+    }
+
+    auto materialize = [&](size_t k) {
+      const auto &candidate = candidates[k];
+      Frontier   &frontier  = expanded[k];
+      frontier              = beams[candidate.beam];
+      const size_t npes     = frontier.pe_t_f.size();
+      if (candidate.config != frontier.config) {
+        const int reconfig_end =
+            frontier.max_t_f + R.cost(frontier.config, candidate.config);
+        frontier.set(1, frontier.reconfig_end, reconfig_end);
+        frontier.set(2, frontier.config, candidate.config);
+        frontier.reconfig_end = reconfig_end;
+        frontier.config       = candidate.config;
+      }
+      int &pe_t_f = frontier.pe_t_f[candidate.pe];
+      frontier.set(3 + candidate.pe, pe_t_f, std::max(pe_t_f, candidate.t_f));
+      pe_t_f = std::max(pe_t_f, candidate.t_f);
+      frontier.set(0, frontier.max_t_f, candidate.max_t_f);
+      frontier.max_t_f = candidate.max_t_f;
+      if (slot[v] != NoSlot) {
+        int &live = frontier.live_t_f[slot[v]];
+        frontier.set(3 + npes + slot[v], live, candidate.t_f);
+        live = candidate.t_f;
+      }
+    };
+
+    next.clear();
+    table.assign(table.size(), NoSlot);
+    expanded.resize(std::max(expanded.size(), candidates.size()));
+    for (size_t k = 0; k < candidates.size() && next.size() < width;) {
+      const size_t batch =
+          std::min(candidates.size(), k + 2 * (width - next.size()));
+      std::partial_sort(
+          candidates.begin() + k,
+          candidates.begin() + batch,
+          candidates.end());
+      if (parallel) {
+        pool->parallel_for(k, batch, materialize);
+      }
+      else {
+        for (size_t b = k; b < batch; b++) {
+          materialize(b);
+        }
+      }
+      for (; k < batch && next.size() < width; k++) {
+        const uint64_t key   = expanded[k].key;
+        size_t         entry = key & (table.size() - 1);
+        while (table[entry] != NoSlot &&
+               not(key == next[table[entry]].key &&
+                   expanded[k] == next[table[entry]])) {
+          entry = (entry + 1) & (table.size() - 1);
+        }
+        if (table[entry] != NoSlot) {
+          continue;
+        }
+        table[entry] = next.size();
+
+        const auto &candidate = candidates[k];
+        history.push_back(Decision{
+            beams[candidate.beam].last,
+            candidate.pe,
+            candidate.config != beams[candidate.beam].config ? candidate.config
+                                                             : C.size()});
+        next.push_back(std::move(expanded[k]));
+        next.back().last = history.size() - 1;
+      }
+    }
+    std::swap(beams, next);
+  }
+
+  // Replay the decisions of the best beam
+  const auto &best = *std::min_element(
+      beams.begin(), beams.end(), [](const auto &a, const auto &b) {
+        return a.max_t_f < b.max_t_f;
+      });
+  std::vector<Decision> decisions;
+  for (size_t d = best.last; d != NoSlot; d = history[d].parent) {
+    decisions.push_back(history[d]);
+  }
+  std::reverse(decisions.begin(), decisions.end());
+  assert(decisions.size() == order.size());
+
+  Schedule S(C, W, Placement::Append, mem);
+  int      last_reconfig = 0;
+  size_t   last_config   = C.size();
+  for (size_t p = 0; p < decisions.size(); p++) {
+    const auto &d = decisions[p];
+    if (d.config != C.size()) {
+      last_reconfig = S.insert_reconfiguration(R.cost(last_config, d.config));
+      last_config   = d.config;
+    }
+    int ready = last_reconfig;
+    for (auto pred : g.preds(order[p])) {
+      ready = std::max(ready, S.t_f(pred));
+    }
+    const PE pe(d.pe);
+    S.schedule_task(order[p], pe, std::max(S.max_t_f(pe), ready) + 1);
+  }
+  assert(S.makespan() == best.max_t_f);
+  return S;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <memory_resource>
+
+#include "dag.hpp"
+#include "ordering.hpp"
+#include "scheduling.hpp"
+#include "thread_pool.hpp"
+
+// Schedules the tasks in order while keeping the width best partial
+// schedules. Each partial schedule is expanded by placing the next task on
+// a PE of the current configuration or after reconfiguring to another one,
+// and the expansions with the earliest finish times are kept. A width of 1
+// follows a single greedy path, larger widths explore more configuration
+// sequences. Uses Placement::Append and Reconfiguration::Global, and expands
+// the partial schedules on the pool if one is given.
+Schedule beam_search(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    size_t                     width,
+    Ordering                   ordering = Ordering::Topological,
+    std::pmr::memory_resource *mem      = std::pmr::get_default_resource(),
+    ThreadPool                *pool     = nullptr);
+// beam_search() on the given topological order of g
+Schedule beam_search(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    const Order               &order,
+    size_t                     width,
+    std::pmr::memory_resource *mem  = std::pmr::get_default_resource(),
+    ThreadPool                *pool = nullptr);
@@ -0,0 +1,319 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <tuple>
+
+#include "algorithms.hpp"
+#include "arena.hpp"
+#include "race.hpp"
+#include "scheduling.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+// Count every heap allocation of the process, so the steady state of the
+// scheduling runs can be checked for heap calls. The workers of the pool
+// allocate concurrently with the main thread.
+static std::atomic<size_t> heap_calls{0};
+
+static void *allocate(size_t size, size_t alignment = 0) noexcept
+{
+  heap_calls.fetch_add(1, std::memory_order_relaxed);
+  size = size ? size : 1;
+  if (alignment > alignof(std::max_align_t)) {
+    // aligned_alloc requires a size that is a multiple of the alignment
+    return std::aligned_alloc(
+        alignment, (size + alignment - 1) / alignment * alignment);
+  }
+  return std::malloc(size);
+}
+
+static void *allocate_or_throw(size_t size, size_t alignment = 0)
+{
+  if (void *p = allocate(size, alignment)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(size_t size)
+{
+  return allocate_or_throw(size);
+}
+
+void *operator new[](size_t size)
+{
+  return allocate_or_throw(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+  return allocate_or_throw(size, size_t(alignment));
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+  return allocate_or_throw(size, size_t(alignment));
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+  return allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+  return allocate(size);
+}
+
+void *operator new(
+    size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+  return allocate(size, size_t(alignment));
+}
+
+void *operator new[](
+    size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+  return allocate(size, size_t(alignment));
+}
+
+// malloc and aligned_alloc are both released with free
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(
+    void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](
+    void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+  std::free(p);
+}
+
+template <typename Run>
+void bench(
+    const std::string &name,
+    int                rho,
+    const DAG         &D,
+    size_t             nconfigs,
+    size_t             threads,
+    Arena             &arena,
+    int                runs,
+    Run                run)
+{
+  int makespan = 0;
+
+  // Warm up, the first run may allocate lazily initialized state
+  {
+    auto s   = run(arena.resource());
+    makespan = s.makespan();
+  }
+  arena.reset();
+
+  const size_t calls_before     = heap_calls.load();
+  size_t       arena_allocs     = 0;
+  size_t       arena_heap_calls = 0;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int r = 0; r < runs; r++) {
+    {
+      auto s = run(arena.resource());
+    }
+    arena_allocs += arena.allocations();
+    arena_heap_calls += arena.heap_allocations();
+    arena.reset();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+  std::cout << name << "," << rho << "," << D.ntasks() << "," << makespan << ","
+            << us.count() / runs << "," << runs << ","
+            << arena_allocs / runs << "," << arena_heap_calls / runs << ","
+            << (heap_calls.load() - calls_before) / runs << "," << nconfigs << ","
+            << threads << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  int      rho      = 2;
+  int      L        = 3;
+  int      runs     = 100;
+  size_t   threads  = 1;
+  Ordering ordering = Ordering::Topological;
+  size_t   K        = 16;
+  if (argc < 2) {
+    std::cout << "No input file given. Usage:" << std::endl
+              << std::endl
+              << "    bench <inputjson>.json [rho] [runs] [L] [threads] [ordering] "
+                 "[K]"
+              << std::endl
+              << std::endl
+              << "Prints algorithm,rho,ntasks,makespan,us per run,runs,"
+              << "arena allocations per run,arena overflows per run,"
+              << "heap calls per run,configurations,threads" << std::endl;
+    return 1;
+  }
+
+  if (argc >= 3) {
+    rho = atoi(argv[2]);
+  }
+  if (argc >= 4) {
+    runs = std::max(1, atoi(argv[3]));
+  }
+  if (argc >= 5) {
+    L = atoi(argv[4]);
+  }
+  if (argc >= 6) {
+    threads = std::max(1, atoi(argv[5]));
+  }
+  if (argc >= 7) {
+    ordering = parse_ordering(argv[6]).value_or(Ordering::Topological);
+  }
+  if (argc >= 8) {
+    K = std::max(1, atoi(argv[7]));
+  }
+
+  // Import
+  std::ifstream  i(argv[1]);
+  nlohmann::json j;
+  i >> j;
+  DAG         D(import_task_graph(j));
+  auto        W = import_costs(j);
+  auto        C = import_configs(j);
+  ConfigCosts T(W, C);
+  auto        R = import_reconfig_costs(j, C.size(), rho);
+
+  Arena      arena(run_memory(D, W, C));
+  ThreadPool pool(threads);
+
+  const std::tuple<std::string, Placement, Reconfiguration> modes[] = {
+      {"", Placement::Append, Reconfiguration::Global},
+      {"-insertion", Placement::Insertion, Reconfiguration::Global},
+      {"-partial", Placement::Append, Reconfiguration::Partial}};
+
+  for (const auto &[suffix, placement, reconfiguration] : modes) {
+    bench(
+        "lsl" + suffix, rho, D, C.size(), threads, arena, runs, [&](auto mem) {
+          return lsl(
+              D,
+              W,
+              C,
+              T,
+              R,
+              L,
+              placement,
+              ordering,
+              reconfiguration,
+              mem,
+              &pool);
+        });
+    bench("cluster" + suffix, rho, D, C.size(), 1, arena, runs, [&](auto mem) {
+      return cluster(
+          D,
+          W,
+          C,
+          T,
+          R,
+          placement,
+          Segmentation::Greedy,
+          ordering,
+          reconfiguration,
+          mem);
+    });
+    bench(
+        "cluster-optimal" + suffix,
+        rho,
+        D,
+        C.size(),
+        1,
+        arena,
+        runs,
+        [&](auto mem) {
+          return cluster(
+              D,
+              W,
+              C,
+              T,
+              R,
+              placement,
+              Segmentation::Optimal,
+              ordering,
+              reconfiguration,
+              mem);
+        });
+    bench("heft" + suffix, rho, D, C.size(), 1, arena, runs, [&](auto mem) {
+      return heft(D, W, C, T, R, placement, reconfiguration, mem);
+    });
+  }
+
+  // The starts run concurrently and allocate from the heap, not the arena
+  bench("multistart-lsl", rho, D, C.size(), threads, arena, runs, [&](auto) {
+    return multistart(D, K, 1, pool, [&](const Order &order) {
+             return lsl(D, W, C, T, R, order, L);
+           })
+        .first;
+  });
+  bench(
+      "multistart-cluster", rho, D, C.size(), threads, arena, runs, [&](auto) {
+        return multistart(D, K, 1, pool, [&](const Order &order) {
+                 return cluster(D, W, C, T, R, order);
+               })
+            .first;
+      });
+
+  return 0;
+}
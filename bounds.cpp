@@ -0,0 +1,130 @@
+#include <bitset>
+#include <limits>
+#include <set>
+#include <vector>
+
+#include "bounds.hpp"
+
+namespace {
+
+// Minimum number of configurations such that each task is supported by one
+// of them. Exact for few configurations, otherwise the configurations which
+// are the only ones to support a task.
+size_t min_configs(const std::set<uint64_t> &supports, size_t nconfigs)
+{
+  if (nconfigs <= 16) {
+    size_t min = nconfigs;
+    for (uint64_t subset = 1; subset < (uint64_t(1) << nconfigs); subset++) {
+      const size_t size = std::bitset<64>(subset).count();
+      if (size < min && std::all_of(supports.begin(), supports.end(),
+                                    [&](auto s) { return s & subset; })) {
+        min = size;
+      }
+    }
+    return min;
+  }
+  uint64_t forced = 0;
+  for (auto s : supports) {
+    if (std::bitset<64>(s).count() == 1) {
+      forced |= s;
+    }
+  }
+  return std::max<size_t>(1, std::bitset<64>(forced).count());
+}
+
+int divide_up(int64_t work, int64_t npes)
+{
+  return (work + npes - 1) / npes;
+}
+
+} // namespace
+
+LowerBounds lower_bounds(
+    const DAG            &g,
+    const Configurations &C,
+    const ConfigCosts    &T,
+    const ReconfigCosts  &R,
+    Reconfiguration       reconfiguration)
+{
+  LowerBounds bounds;
+  if (g.ntasks() == 0 || C.empty()) {
+    return bounds;
+  }
+  const size_t nc = C.size();
+
+  int min_initial = std::numeric_limits<int>::max();
+  int min_switch  = std::numeric_limits<int>::max();
+  std::vector<int> min_into(nc, std::numeric_limits<int>::max());
+  size_t           max_pes = 0;
+  for (size_t c = 0; c < nc; c++) {
+    min_initial = std::min(min_initial, R.cost(nc, c));
+    min_into[c] = std::min(min_into[c], R.cost(nc, c));
+    max_pes     = std::max(max_pes, C[c].pes.size());
+    for (size_t from = 0; from < nc; from++) {
+      if (from != c) {
+        min_switch  = std::min(min_switch, R.cost(from, c));
+        min_into[c] = std::min(min_into[c], R.cost(from, c));
+      }
+    }
+  }
+
+  // Minimum cost of each task and the configurations supporting it
+  std::vector<int>     min_cost(g.ntasks(), std::numeric_limits<int>::max());
+  std::vector<int64_t> only_work(nc, 0);
+  std::set<uint64_t>   supports;
+  int64_t              work = 0;
+  for (Vertex v = 0; v < g.ntasks(); v++) {
+    uint64_t supported   = 0;
+    size_t   nsupporting = 0;
+    size_t   only        = 0;
+    for (size_t c = 0; c < nc; c++) {
+      if (T.supports(v, c)) {
+        min_cost[v] = std::min(min_cost[v], T.min_cost(v, c));
+        supported |= nc <= 64 ? uint64_t(1) << c : 0;
+        only = c;
+        nsupporting++;
+      }
+    }
+    work += min_cost[v] + 1;
+    if (nsupporting == 1) {
+      only_work[only] += min_cost[v] + 1;
+    }
+    supports.insert(supported);
+  }
+
+  // A task starts one time unit after its predecessors finish, and finishes
+  // its cost after it starts
+  std::vector<int> bottom(g.ntasks(), 0);
+  const auto      &order = g.order();
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    int below = 0;
+    for (auto succ : g.succs(*it)) {
+      below = std::max(below, bottom[succ]);
+    }
+    bottom[*it]          = 1 + min_cost[*it] + below;
+    bounds.critical_path = std::max(bounds.critical_path, bottom[*it]);
+  }
+  bounds.critical_path += min_initial;
+
+  bounds.work = min_initial + divide_up(work, max_pes);
+  for (size_t c = 0; c < nc; c++) {
+    if (only_work[c] > 0) {
+      bounds.work = std::max(
+          bounds.work, min_into[c] + divide_up(only_work[c], C[c].pes.size()));
+    }
+  }
+
+  bounds.nconfigs = nc <= 64 ? min_configs(supports, nc) : 1;
+  // Partial reconfigurations overlap with tasks on other regions
+  if (reconfiguration == Reconfiguration::Global) {
+    bounds.reconfiguration = min_initial +
+                             int(bounds.nconfigs - 1) * min_switch +
+                             divide_up(work, max_pes);
+  }
+  return bounds;
+}
+
+double gap(int makespan, int lower_bound)
+{
+  return lower_bound > 0 ? double(makespan - lower_bound) / lower_bound : 0.0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+
+#include "dag.hpp"
+#include "scheduling.hpp"
+
+// Lower bounds on the makespan of any schedule of a graph
+struct LowerBounds {
+  // Longest path with the minimum cost of each task, after the cheapest
+  // initial configuration
+  int critical_path   = 0;
+  // Total minimum cost over the PEs of the largest configuration, and of the
+  // tasks only supported in a configuration over its PEs
+  int work            = 0;
+  // Work plus the reconfigurations needed to load enough configurations to
+  // support all tasks, which are exclusive with Reconfiguration::Global
+  int reconfiguration = 0;
+  // Minimum number of configurations that have to be loaded
+  size_t nconfigs     = 0;
+
+  int makespan() const
+  {
+    return std::max({critical_path, work, reconfiguration});
+  }
+};
+
+LowerBounds lower_bounds(
+    const DAG            &g,
+    const Configurations &C,
+    const ConfigCosts    &T,
+    const ReconfigCosts  &R,
+    Reconfiguration       reconfiguration = Reconfiguration::Global);
+
+// Relative distance of a makespan from the lower bound
+double gap(int makespan, int lower_bound);
@@ -0,0 +1,511 @@
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "algorithms.hpp"
+#include "bounds.hpp"
+#include "branch_bound.hpp"
+
+namespace {
+
+constexpr size_t NoConfig = std::numeric_limits<size_t>::max();
+// Cost of a reconfiguration that cannot happen, small enough to add times to
+constexpr int    Never    = std::numeric_limits<int>::max() / 4;
+
+// Visited states kept for the dominance check
+constexpr size_t MaxStates       = 1 << 18;
+constexpr size_t MaxStatesPerKey = 1024;
+
+// Scheduling v on pe, reconfiguring to config first unless it is NoConfig
+struct Decision {
+  Vertex v;
+  size_t pe;
+  size_t config;
+};
+
+struct Child {
+  Decision decision;
+  int      t_f;
+  int      lower_bound;
+};
+
+class Search {
+  public:
+  Search(
+      const DAG            &graph,
+      const CostMatrix     &costs,
+      const Configurations &configurations,
+      const ConfigCosts    &config_costs,
+      const ReconfigCosts  &reconfig_costs,
+      int                   incumbent,
+      std::chrono::steady_clock::time_point stop)
+    : g(graph)
+    , W(costs)
+    , C(configurations)
+    , T(config_costs)
+    , R(reconfig_costs)
+    , n(graph.ntasks())
+    , deadline(stop)
+    , min_cost(n, CostMatrix::Unsupported)
+    , bottom(n, 0)
+    , only(n, NoConfig)
+    , pe_class(W.npes(), 0)
+    , representatives(C.size())
+    , min_switch(C.size() + 1, Never)
+    , min_into(C.size(), Never)
+    , zobrist(n)
+    , zobrist_config(C.size() + 1)
+    , done(n, false)
+    , missing(n, 0)
+    , pending_succs(n, 0)
+    , t_f(n, 0)
+    , preds_t_f(n, 0)
+    , pe_t_f(W.npes(), 0)
+    , config(C.size())
+    , remaining_only(C.size(), 0)
+  {
+    best = incumbent;
+    for (Vertex v = 0; v < n; v++) {
+      size_t nsupporting = 0;
+      for (size_t c = 0; c < C.size(); c++) {
+        if (T.supports(v, c)) {
+          min_cost[v] = std::min(min_cost[v], T.min_cost(v, c));
+          only[v]     = c;
+          nsupporting++;
+        }
+      }
+      if (nsupporting != 1) {
+        only[v] = NoConfig;
+      }
+      missing[v]       = g.preds(v).size();
+      pending_succs[v] = g.succs(v).size();
+      remaining_work += min_cost[v] + 1;
+      if (only[v] != NoConfig) {
+        remaining_only[only[v]] += min_cost[v] + 1;
+      }
+    }
+
+    // A task finishes at least its minimum cost after its predecessors, and
+    // its successors at least their bottom levels after it
+    const auto &order = g.order();
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+      int below = 0;
+      for (auto succ : g.succs(*it)) {
+        below = std::max(below, bottom[succ]);
+      }
+      bottom[*it] = 1 + min_cost[*it] + below;
+    }
+
+    // PEs with the same costs for all tasks are interchangeable
+    for (size_t p = 0; p < W.npes(); p++) {
+      pe_class[p] = p;
+      for (size_t q = 0; q < p; q++) {
+        bool same = true;
+        for (Vertex v = 0; v < n && same; v++) {
+          same = W.cost(v, PE(p)) == W.cost(v, PE(q));
+        }
+        if (same) {
+          pe_class[p] = pe_class[q];
+          break;
+        }
+      }
+    }
+
+    for (size_t c = 0; c < C.size(); c++) {
+      max_pes = std::max(max_pes, C[c].pes.size());
+      min_switch[C.size()] =
+          std::min(min_switch[C.size()], R.cost(C.size(), c));
+      for (size_t to = 0; to < C.size(); to++) {
+        if (to != c) {
+          min_switch[c] = std::min(min_switch[c], R.cost(c, to));
+          min_into[to]  = std::min(min_into[to], R.cost(c, to));
+        }
+      }
+    }
+    for (size_t c = 0; c < C.size(); c++) {
+      min_into[c] = std::min(min_into[c], R.cost(C.size(), c));
+    }
+
+    std::mt19937_64 random(n);
+    for (auto &z : zobrist) {
+      z = random();
+    }
+    for (auto &z : zobrist_config) {
+      z = random();
+    }
+  }
+
+  // Lower bound on the makespan of any schedule completing the current one
+  // from the remaining work, which is cheap, and the critical paths, which
+  // take a pass over the tasks
+  int lower_bound() const
+  {
+    return std::max(work_bound(), path_bound());
+  }
+
+  // Work over the PEs, the remaining work starts after start at the earliest
+  int work_bound() const
+  {
+    int bound = max_t_f;
+    int start = max_t_f + min_switch[config];
+    if (config != C.size()) {
+      int free = std::numeric_limits<int>::max();
+      for (const auto &pe : C[config].pes) {
+        free = std::min(free, pe_t_f[pe.offset]);
+      }
+      start = std::min(start, std::max(free, reconfig_end));
+    }
+    if (remaining_work > 0 && max_pes > 0) {
+      bound = std::max<int64_t>(
+          bound, start + (remaining_work + max_pes - 1) / max_pes);
+    }
+    // Work of the tasks only supported in one configuration over its PEs
+    for (size_t c = 0; c < C.size(); c++) {
+      if (remaining_only[c] == 0) {
+        continue;
+      }
+      const int     c_start = c == config ? start : max_t_f + min_into[c];
+      const int64_t npes    = C[c].pes.size();
+      bound                 = std::max<int64_t>(
+          bound, c_start + (remaining_only[c] + npes - 1) / npes);
+    }
+    return bound;
+  }
+
+  // Critical paths from the ready tasks, and from the tasks which need
+  // another reconfiguration, which starts after all scheduled tasks
+  int path_bound() const
+  {
+    int       bound    = max_t_f;
+    const int switched = max_t_f + min_switch[config];
+    for (Vertex v = 0; v < n; v++) {
+      if (done[v]) {
+        continue;
+      }
+      int ready = missing[v] > 0 ? 0 : std::max(reconfig_end, preds_t_f[v]);
+      if (config == C.size() || not T.supports(v, config)) {
+        ready = std::max(ready, switched);
+      }
+      bound = std::max(bound, ready + bottom[v]);
+    }
+    return bound;
+  }
+
+  void run(int bound)
+  {
+    root_bound = std::max(bound, lower_bound());
+    expand(root_bound);
+  }
+
+  const DAG            &g;
+  const CostMatrix     &W;
+  const Configurations &C;
+  const ConfigCosts    &T;
+  const ReconfigCosts  &R;
+  const size_t          n;
+  std::chrono::steady_clock::time_point deadline;
+
+  // Best complete schedule found, empty if none beats the incumbent
+  std::vector<Decision> best_path;
+  int                   best;
+  int                   root_bound = 0;
+  // Minimum lower bound of the nodes not searched within the budget
+  int                   open_bound = std::numeric_limits<int>::max();
+  bool                  timed_out  = false;
+  size_t                nodes      = 0;
+  size_t                pruned     = 0;
+  size_t                dominated  = 0;
+
+  private:
+  struct State {
+    std::vector<bool> done;
+    std::vector<int>  values;
+  };
+
+  // The state of a node that determines the schedules of its subtree: the
+  // end of the last reconfiguration, the finish times of the PEs of the
+  // current configuration and of the tasks with successors left to schedule.
+  // With the same tasks done in the same configuration, a node whose values
+  // are all at least those of a visited node cannot lead to a shorter
+  // schedule.
+  bool is_dominated()
+  {
+    values.assign({max_t_f, reconfig_end});
+    if (config != C.size()) {
+      for (const auto &pe : C[config].pes) {
+        values.push_back(pe_t_f[pe.offset]);
+      }
+    }
+    for (Vertex v = 0; v < n; v++) {
+      if (done[v] && pending_succs[v] > 0) {
+        values.push_back(t_f[v]);
+      }
+    }
+
+    // The values usually differ early, the done tasks rarely differ for the
+    // same key
+    auto &states = visited[hash ^ zobrist_config[config]];
+    for (const auto &state : states) {
+      if (state.values.size() == values.size() &&
+          std::equal(
+              values.begin(),
+              values.end(),
+              state.values.begin(),
+              [](int value, int other) { return other <= value; }) &&
+          state.done == done) {
+        return true;
+      }
+    }
+    if (nvisited < MaxStates && states.size() < MaxStatesPerKey) {
+      states.push_back(State{done, values});
+      nvisited++;
+    }
+    return false;
+  }
+
+  // Applies d and returns what is needed to undo it
+  std::tuple<int, int, int, size_t> apply(const Decision &d)
+  {
+    const auto saved = std::make_tuple(
+        max_t_f, reconfig_end, pe_t_f[d.pe], config);
+    if (d.config != NoConfig) {
+      reconfig_end = max_t_f + R.cost(config, d.config);
+      config       = d.config;
+    }
+    const int ready = std::max(reconfig_end, preds_t_f[d.v]);
+    t_f[d.v] = std::max(pe_t_f[d.pe], ready) + 1 + W.cost(d.v, PE(d.pe));
+    pe_t_f[d.pe] = std::max(pe_t_f[d.pe], t_f[d.v]);
+    max_t_f      = std::max(max_t_f, t_f[d.v]);
+
+    done[d.v] = true;
+    hash ^= zobrist[d.v];
+    remaining_work -= min_cost[d.v] + 1;
+    if (only[d.v] != NoConfig) {
+      remaining_only[only[d.v]] -= min_cost[d.v] + 1;
+    }
+    for (auto pred : g.preds(d.v)) {
+      pending_succs[pred]--;
+    }
+    for (auto succ : g.succs(d.v)) {
+      missing[succ]--;
+      saved_preds_t_f.push_back(preds_t_f[succ]);
+      preds_t_f[succ] = std::max(preds_t_f[succ], t_f[d.v]);
+    }
+    ndone++;
+    path.push_back(d);
+    return saved;
+  }
+
+  void undo(const Decision &d, const std::tuple<int, int, int, size_t> &state)
+  {
+    std::tie(max_t_f, reconfig_end, pe_t_f[d.pe], config) = state;
+    done[d.v] = false;
+    hash ^= zobrist[d.v];
+    remaining_work += min_cost[d.v] + 1;
+    if (only[d.v] != NoConfig) {
+      remaining_only[only[d.v]] += min_cost[d.v] + 1;
+    }
+    for (auto pred : g.preds(d.v)) {
+      pending_succs[pred]++;
+    }
+    const auto succs = g.succs(d.v);
+    for (auto succ = std::make_reverse_iterator(succs.end());
+         succ != std::make_reverse_iterator(succs.begin());
+         ++succ) {
+      missing[*succ]++;
+      preds_t_f[*succ] = saved_preds_t_f.back();
+      saved_preds_t_f.pop_back();
+    }
+    ndone--;
+    path.pop_back();
+  }
+
+  void expand(int bound)
+  {
+    if (timed_out || (++nodes % 256 == 0 &&
+                      std::chrono::steady_clock::now() >= deadline)) {
+      timed_out  = true;
+      open_bound = std::min(open_bound, bound);
+      return;
+    }
+    if (ndone == n) {
+      if (max_t_f < best) {
+        best      = max_t_f;
+        best_path = path;
+      }
+      return;
+    }
+    if (is_dominated()) {
+      dominated++;
+      return;
+    }
+
+    std::vector<Child> children;
+    auto add = [&](Vertex v, size_t pe, size_t to) {
+      const Decision d{v, pe, to};
+      const auto     state = apply(d);
+      // The path bound is only needed if the work bound does not prune
+      const int work = work_bound();
+      if (work >= best) {
+        pruned++;
+      }
+      else {
+        children.push_back(
+            Child{d, t_f[v], std::max(work, path_bound())});
+      }
+      undo(d, state);
+    };
+    // Skip PEs interchangeable with an earlier one, which have the same
+    // costs for all tasks. After a reconfiguration, all PEs of the
+    // configuration are free.
+    for (size_t c = 0; c < C.size(); c++) {
+      const auto &pes = C[c].pes;
+      representatives[c].clear();
+      for (auto pe = pes.begin(); pe != pes.end(); ++pe) {
+        if (std::none_of(pes.begin(), pe, [&](const PE &other) {
+              return pe_class[other.offset] == pe_class[pe->offset] &&
+                     (c != config ||
+                      pe_t_f[other.offset] == pe_t_f[pe->offset]);
+            })) {
+          representatives[c].push_back(pe->offset);
+        }
+      }
+    }
+    for (Vertex v = 0; v < n; v++) {
+      if (done[v] || missing[v] > 0) {
+        continue;
+      }
+      for (size_t c = 0; c < C.size(); c++) {
+        if (not T.supports(v, c)) {
+          continue;
+        }
+        for (auto pe : representatives[c]) {
+          if (W.supports(v, PE(pe))) {
+            add(v, pe, c == config ? NoConfig : c);
+          }
+        }
+      }
+    }
+
+    std::sort(children.begin(), children.end(), [](const auto &a, const auto &b) {
+      return std::tie(a.lower_bound, a.t_f) < std::tie(b.lower_bound, b.t_f);
+    });
+    for (const auto &child : children) {
+      if (child.lower_bound >= best) {
+        pruned++;
+        continue;
+      }
+      const auto state = apply(child.decision);
+      expand(child.lower_bound);
+      undo(child.decision, state);
+    }
+  }
+
+  // Per task minimum cost over all configurations, bottom level, and the
+  // only configuration supporting it or NoConfig
+  std::vector<int>      min_cost;
+  std::vector<int>      bottom;
+  std::vector<size_t>   only;
+  std::vector<size_t>   pe_class;
+  // PEs of each configuration to branch on at the current node
+  std::vector<std::vector<size_t>> representatives;
+  size_t                max_pes = 0;
+  // Minimum cost of reconfiguring from and into each configuration
+  std::vector<int>      min_switch;
+  std::vector<int>      min_into;
+  std::vector<uint64_t> zobrist;
+  std::vector<uint64_t> zobrist_config;
+
+  std::vector<bool>     done;
+  // Predecessors and successors of each task left to schedule
+  std::vector<uint32_t> missing;
+  std::vector<uint32_t> pending_succs;
+  std::vector<int>      t_f;
+  // Latest finish time of the scheduled predecessors of each task, and the
+  // values overwritten by apply() for undo()
+  std::vector<int>      preds_t_f;
+  std::vector<int>      saved_preds_t_f;
+  std::vector<int>      pe_t_f;
+  int                   max_t_f      = 0;
+  int                   reconfig_end = 0;
+  size_t                config;
+  int64_t               remaining_work = 0;
+  std::vector<int64_t>  remaining_only;
+  size_t                ndone = 0;
+  uint64_t              hash  = 0;
+  std::vector<Decision> path;
+
+  // Values of the current node for the dominance check
+  std::vector<int>                                 values;
+  std::unordered_map<uint64_t, std::vector<State>> visited;
+  size_t                                           nvisited = 0;
+};
+
+} // namespace
+
+Schedule branch_and_bound(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    std::chrono::milliseconds  budget,
+    BranchBoundStats          *stats,
+    std::pmr::memory_resource *mem)
+{
+  const auto deadline = std::chrono::steady_clock::now() + budget;
+
+  // Warm start
+  Schedule warm = lsl(g, W, C, T, R, 3, Placement::Append,
+                      Ordering::Topological, Reconfiguration::Global, mem);
+  {
+    Schedule clustered = cluster(g, W, C, T, R, Placement::Append,
+                                 Segmentation::Optimal, Ordering::Topological,
+                                 Reconfiguration::Global, mem);
+    if (clustered.makespan() < warm.makespan()) {
+      warm = std::move(clustered);
+    }
+  }
+
+  Search search(g, W, C, T, R, warm.makespan(), deadline);
+  search.run(lower_bounds(g, C, T, R).makespan());
+
+  if (stats) {
+    stats->initial_makespan = warm.makespan();
+    stats->lower_bound =
+        search.timed_out
+            ? std::max(search.root_bound, std::min(search.best, search.open_bound))
+            : search.best;
+    stats->nodes     = search.nodes;
+    stats->pruned    = search.pruned;
+    stats->dominated = search.dominated;
+    stats->optimal   = stats->lower_bound == search.best;
+  }
+  if (search.best_path.empty()) {
+    return warm;
+  }
+
+  // Build the schedule of the best decisions
+  Schedule S(C, W, Placement::Append, mem);
+  int      last_reconfig = 0;
+  size_t   last_config   = C.size();
+  for (const auto &d : search.best_path) {
+    if (d.config != NoConfig) {
+      last_reconfig = S.insert_reconfiguration(R.cost(last_config, d.config));
+      last_config   = d.config;
+    }
+    int ready = last_reconfig;
+    for (auto pred : g.preds(d.v)) {
+      ready = std::max(ready, S.t_f(pred));
+    }
+    const PE pe(d.pe);
+    S.schedule_task(d.v, pe, std::max(S.max_t_f(pe), ready) + 1);
+  }
+  assert(S.makespan() == search.best);
+  return S;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+#include <chrono>
+#include <memory_resource>
+
+#include "dag.hpp"
+#include "scheduling.hpp"
+
+struct BranchBoundStats {
+  int    initial_makespan = 0;
+  // Proven lower bound on the makespan, equal to the makespan if optimal
+  int    lower_bound      = 0;
+  size_t nodes            = 0;
+  size_t pruned           = 0;
+  size_t dominated        = 0;
+  bool   optimal          = false;
+};
+
+// Searches the schedules with Placement::Append and Reconfiguration::Global
+// by branching on the next task among the ready ones, its PE, and whether to
+// reconfigure before it. The search starts from the better schedule of lsl()
+// and cluster() and prunes nodes by critical path and work per configuration
+// bounds, and nodes dominated by a visited node with the same tasks done in
+// the same configuration. If the budget runs out, the best schedule found is
+// returned and stats holds the remaining gap.
+Schedule branch_and_bound(
+    const DAG                 &g,
+    const CostMatrix          &W,
+    const Configurations      &C,
+    const ConfigCosts         &T,
+    const ReconfigCosts       &R,
+    std::chrono::milliseconds  budget,
+    BranchBoundStats          *stats = nullptr,
+    std::pmr::memory_resource *mem   = std::pmr::get_default_resource());
@@ -1,16 +1,20 @@
 #include <iostream>
 #include "algorithms.hpp"
+#include "bounds.hpp"
 #include "scheduling.hpp"
 #include "util.hpp"
 
-int rho = 2;
-
 int main(int argc, char **argv)
 {
+  int rho = 2;
   if (argc < 2) {
     std::cout << "No input file given. Usage:" << std::endl
               << std::endl
-              << "    cluster <inputjson>.json [rho]" << std::endl;
+              << "    cluster <inputjson>.json [rho] [append|insertion] "
+                 "[greedy|optimal] "
+                 "[topological|critical-path|bottom-level|affinity|level] "
+                 "[global|partial]"
+              << std::endl;
     return 1;
   }
 
@@ -18,26 +22,51 @@ int main(int argc, char **argv)
   if (argc >= 3) {
     rho = atoi(argv[2]);
   }
+  Placement    placement    = Placement::Append;
+  Segmentation segmentation = Segmentation::Greedy;
+  Ordering     ordering     = Ordering::Topological;
+  auto         reconfiguration = Reconfiguration::Global;
+  for (int arg = 3; arg < argc; arg++) {
+    if (std::string(argv[arg]) == "insertion") {
+      placement = Placement::Insertion;
+    }
+    else if (std::string(argv[arg]) == "optimal") {
+      segmentation = Segmentation::Optimal;
+    }
+    else if (std::string(argv[arg]) == "partial") {
+      reconfiguration = Reconfiguration::Partial;
+    }
+    else if (auto o = parse_ordering(argv[arg])) {
+      ordering = *o;
+    }
+  }
 
   // Import
   std::ifstream  i(argv[1]);
   nlohmann::json j;
   i >> j;
-  auto G = import_task_graph(j);
+  DAG  D(import_task_graph(j));
+  auto W = import_costs(j);
   auto C = import_configs(j);
+  ConfigCosts T(W, C);
+  auto        R = import_reconfig_costs(j, C.size(), rho);
 
   auto start = std::chrono::high_resolution_clock::now();
-  auto s     = cluster(G, C);
+  auto s     = cluster(
+      D, W, C, T, R, placement, segmentation, ordering, reconfiguration);
   auto end   = std::chrono::high_resolution_clock::now();
 
   auto ms =
       std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-  std::cout << "cluster," << rho << "," << boost::num_vertices(G) << ","
+  const int lower_bound =
+      lower_bounds(D, C, T, R, reconfiguration).makespan();
+  std::cout << "cluster," << rho << "," << D.ntasks() << ","
             << s.makespan() << "," << ms.count() << "," << s.reconfigs.size()
+            << "," << lower_bound << "," << gap(s.makespan(), lower_bound)
             << std::endl;
 
   json_path.replace_extension("svg");
-  export_svg(s, json_path.filename());
+  export_svg(s, D, json_path.filename());
 
   return 0;
 }
@@ -0,0 +1,78 @@
+#include <cassert>
+#include <iterator>
+
+#include <boost/graph/topological_sort.hpp>
+
+#include "dag.hpp"
+
+DAG::DAG(const Graph &g)
+{
+  const size_t ntasks = boost::num_vertices(g);
+  const size_t nedges = boost::num_edges(g);
+  assert(nedges < std::numeric_limits<Index>::max());
+
+  pred_offsets.assign(ntasks + 1, 0);
+  succ_offsets.assign(ntasks + 1, 0);
+  pred_list.resize(nedges);
+  succ_list.resize(nedges);
+  names.reserve(ntasks);
+
+  for (size_t v = 0; v < ntasks; v++) {
+    names.push_back(g[v].name);
+    pred_offsets[v + 1] = pred_offsets[v] + boost::out_degree(v, g);
+
+    auto preds = boost::adjacent_vertices(v, g);
+    std::copy(preds.first, preds.second, pred_list.begin() + pred_offsets[v]);
+    for (auto pred = preds.first; pred != preds.second; ++pred) {
+      succ_offsets[*pred + 1]++;
+    }
+  }
+
+  // Transpose the predecessor lists to get the successor lists
+  for (size_t v = 0; v < ntasks; v++) {
+    succ_offsets[v + 1] += succ_offsets[v];
+  }
+  std::vector<Index> fill(succ_offsets.begin(), succ_offsets.end() - 1);
+  for (size_t v = 0; v < ntasks; v++) {
+    for (auto pred : preds(v)) {
+      succ_list[fill[pred]++] = v;
+    }
+  }
+
+  topo_order.reserve(ntasks);
+  boost::topological_sort(g, std::back_inserter(topo_order));
+}
+
+size_t DAG::ntasks() const
+{
+  return names.size();
+}
+
+size_t DAG::nedges() const
+{
+  return pred_list.size();
+}
+
+DAG::Vertices DAG::preds(Vertex v) const
+{
+  return Vertices(
+      pred_list.begin() + pred_offsets[v],
+      pred_list.begin() + pred_offsets[v + 1]);
+}
+
+DAG::Vertices DAG::succs(Vertex v) const
+{
+  return Vertices(
+      succ_list.begin() + succ_offsets[v],
+      succ_list.begin() + succ_offsets[v + 1]);
+}
+
+const std::vector<Vertex> &DAG::order() const
+{
+  return topo_order;
+}
+
+const std::string &DAG::name(Vertex v) const
+{
+  return names[v];
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/range/iterator_range.hpp>
+
+#include "scheduling.hpp"
+
+// Immutable compressed sparse row representation of the task graph, built
+// once from the imported Graph. As in Graph, an edge from u to v means that u
+// depends on v, i.e. v is a predecessor of u.
+class DAG {
+  public:
+  using Index    = std::uint32_t;
+  using Vertices = boost::iterator_range<std::vector<Index>::const_iterator>;
+
+  explicit DAG(const Graph &g);
+
+  size_t                     ntasks() const;
+  size_t                     nedges() const;
+  Vertices                   preds(Vertex v) const;
+  Vertices                   succs(Vertex v) const;
+  const std::vector<Vertex> &order() const;
+  const std::string         &name(Vertex v) const;
+
+  private:
+  // preds(v) is pred_list[pred_offsets[v], pred_offsets[v + 1])
+  std::vector<Index>       pred_offsets;
+  std::vector<Index>       pred_list;
+  std::vector<Index>       succ_offsets;
+  std::vector<Index>       succ_list;
+  // Topological order in which every task comes after its predecessors
+  std::vector<Vertex>      topo_order;
+  std::vector<std::string> names;
+};
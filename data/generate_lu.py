@@ -14,17 +14,31 @@ configs = ["config1", "config2"]
 P_config = ["config1", "config1", "config1", "config2", "config2", "config2", "config2"]
 
 if len(sys.argv) < 2:
-    print("Usage: generate_lu.py <nblocks>")
+    print("Usage: generate_lu.py <nblocks> [nconfigs]")
+    print("")
+    print("nconfigs: number of configurations, all beyond the first two have")
+    print("          four PEs which only run the internal blocks")
     exit(1)
 
+extra_configs = []
+if len(sys.argv) > 2:
+    extra_configs = [f"config{c + 1}" for c in range(2, int(sys.argv[2]))]
+    configs += extra_configs
+    P_config += [c for c in extra_configs for p in range(4)]
+
+def extra_cost(c):
+    return 120 + (37 * c) % 116
+
 def cost_fun(idx):
     (it, i, j) = ridx(idx)
+    extra = [False for c in extra_configs for p in range(4)]
     if it == i and it == j:
-        return [235, False, False, False, False, False, False]
+        return [235, False, False, False, False, False, False] + extra
     if it == j or it == i:
-        return [False, 235, False, False, False, False, False]
+        return [False, 235, False, False, False, False, False] + extra
     else:
-        return [False, False, 235, 120, 120, 120, 120]
+        extra = [extra_cost(c) for c in range(len(extra_configs)) for p in range(4)]
+        return [False, False, 235, 120, 120, 120, 120] + extra
 
 blocks = int(sys.argv[1])
 
@@ -14,10 +14,11 @@ configs = ["config1", "config2"]
 P_config = ["config1", "config1", "config1", "config2", "config2", "config2", "config2"]
 
 if len(sys.argv) < 2:
-    print("Usage: generate_random.py <ntasks> [connectivity] [concurrency]")
+    print("Usage: generate_random.py <ntasks> [connectivity] [concurrency] [nconfigs]")
     print("")
     print("connectivity: chance of a connection from one node to its predecessor")
     print("concurrency: maxmium concurrent tasks")
+    print("nconfigs: number of configurations with three PEs each")
     exit(1)
 
 costmax = 500
@@ -32,6 +33,9 @@ if (len(sys.argv) > 2):
     connectivity = int(sys.argv[2])
 if (len(sys.argv) > 3):
     concurrency = int(sys.argv[3])
+if (len(sys.argv) > 4):
+    configs = [f"config{c + 1}" for c in range(int(sys.argv[4]))]
+    P_config = [c for c in configs for p in range(3)]
 
 tasks = range(ntasks)
 
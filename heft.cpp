@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "algorithms.hpp"
+#include "scheduling.hpp"
+#include "util.hpp"
+
+int main(int argc, char **argv)
+{
+  int       rho       = 2;
+  Placement placement = Placement::Append;
+  auto      reconfiguration = Reconfiguration::Global;
+  if (argc < 2) {
+    std::cout << "No input file given. Usage:" << std::endl
+              << std::endl
+              << "    heft <inputjson>.json [rho] [append|insertion] [global|partial]"
+              << std::endl;
+    return 1;
+  }
+
+  std::filesystem::path json_path(argv[1]);
+  if(argc >= 3) {
+    rho = atoi(argv[2]);
+  }
+  for (int arg = 3; arg < argc; arg++) {
+    if (std::string(argv[arg]) == "insertion") {
+      placement = Placement::Insertion;
+    }
+    else if (std::string(argv[arg]) == "partial") {
+      reconfiguration = Reconfiguration::Partial;
+    }
+  }
+
+  // Import
+  std::ifstream  i(json_path);
+  nlohmann::json j;
+  i >> j;
+  DAG  D(import_task_graph(j));
+  auto W = import_costs(j);
+  auto C = import_configs(j);
+  ConfigCosts T(W, C);
+  auto        R = import_reconfig_costs(j, C.size(), rho);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  auto s = heft(D, W, C, T, R, placement, reconfiguration);
+  auto end = std::chrono::high_resolution_clock::now();
+
+  auto ms =
+      std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+  std::cout << "heft," << rho << "," << D.ntasks() << "," << s.makespan() << ","
+            << ms.count() << "," << s.reconfigs.size() << std::endl;
+
+  json_path.replace_extension("svg");
+
+  export_svg(s, D, json_path.filename());
+
+  return 0;
+}
@@ -1,23 +1,71 @@
 #include <algorithm>
+#include <charconv>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include "json.hpp"
+#include <optional>
+#include <sstream>
 
 #include "algorithms.hpp"
+#include "bounds.hpp"
+#include "race.hpp"
 #include "scheduling.hpp"
 #include "util.hpp"
 
-int rho = 2;
+// The cache of auto L holds one line per graph with its features and L:
+// ntasks,nedges,nconfigs,npes,mean reconfiguration cost,placement,ordering,
+// reconfiguration,L. Lines with an L which does not parse are skipped, so a
+// corrupt cache falls back to the search.
+static std::optional<size_t> cached_L(
+    const std::string &cache, const std::string &features)
+{
+  std::ifstream in(cache);
+  std::string   line;
+  while (std::getline(in, line)) {
+    const auto comma = line.rfind(',');
+    if (comma == std::string::npos || line.compare(0, comma, features) != 0) {
+      continue;
+    }
+    size_t      L     = 0;
+    const char *first = line.data() + comma + 1;
+    const char *last  = line.data() + line.size();
+    auto [end, error] = std::from_chars(first, last, L);
+    if (error == std::errc() && end == last && end != first && L > 0) {
+      return L;
+    }
+  }
+  return std::nullopt;
+}
 
 int main(int argc, char **argv)
 {
-  int L = 3;
-  if (argc < 2) {
-    std::cout << "No input file given. Usage:" << std::endl
+  int         rho             = 2;
+  int         L               = 3;
+  bool        auto_L          = false;
+  std::string cache;
+  Placement   placement       = Placement::Append;
+  Ordering    ordering        = Ordering::Topological;
+  auto        reconfiguration = Reconfiguration::Global;
+  auto usage = []() {
+    std::cout << "Usage:" << std::endl
+              << std::endl
+              << "    schedule <inputjson>.mzn [rho] [L|auto|auto:<cache>] "
+                 "[append|insertion] "
+                 "[topological|critical-path|bottom-level|affinity|level] "
+                 "[global|partial]"
+              << std::endl
+              << std::endl
+              << "auto tries L = 1, 2, 3, 4, 6, 8, 12, ... up to the number "
+                 "of tasks and keeps"
               << std::endl
-              << "    schedule <inputjson>.mzn [rho] [L]" << std::endl;
+              << "the best, auto:<cache> reuses the L found for graphs with "
+                 "the same features."
+              << std::endl;
     return 1;
+  };
+  if (argc < 2) {
+    std::cout << "No input file given. ";
+    return usage();
   }
 
   std::filesystem::path json_path(argv[1]);
@@ -25,28 +73,100 @@ int main(int argc, char **argv)
     rho = atoi(argv[2]);
   }
   if(argc >= 4) {
-    L = atoi(argv[3]);
+    const std::string arg(argv[3]);
+    if (arg == "auto") {
+      auto_L = true;
+    }
+    else if (arg.rfind("auto:", 0) == 0 && arg.size() > 5) {
+      auto_L = true;
+      cache  = arg.substr(5);
+    }
+    else if (arg.rfind("auto", 0) == 0) {
+      return usage();
+    }
+    else {
+      L = atoi(argv[3]);
+    }
+  }
+  for (int arg = 4; arg < argc; arg++) {
+    if (std::string(argv[arg]) == "insertion") {
+      placement = Placement::Insertion;
+    }
+    else if (std::string(argv[arg]) == "partial") {
+      reconfiguration = Reconfiguration::Partial;
+    }
+    else if (auto o = parse_ordering(argv[arg])) {
+      ordering = *o;
+    }
   }
 
   // Import
   std::ifstream  i(json_path);
   nlohmann::json j;
   i >> j;
-  auto G = import_task_graph(j);
+  DAG  D(import_task_graph(j));
+  auto W = import_costs(j);
   auto C = import_configs(j);
+  ConfigCosts T(W, C);
+  auto        R = import_reconfig_costs(j, C.size(), rho);
+
+  // Graphs with the same features share the L of the cache
+  int64_t reconfig_cost = 0;
+  for (size_t to = 0; to < C.size(); to++) {
+    for (size_t from = 0; from <= C.size(); from++) {
+      reconfig_cost += from != to ? R.cost(from, to) : 0;
+    }
+  }
+  reconfig_cost /= std::max<int64_t>(1, C.size() * C.size());
+  std::stringstream features;
+  features << D.ntasks() << "," << D.nedges() << "," << C.size() << ","
+           << W.npes() << "," << reconfig_cost << "," << int(placement) << ","
+           << int(ordering) << "," << int(reconfiguration);
+  std::optional<size_t> cached;
+  if (auto_L && not cache.empty()) {
+    cached = cached_L(cache, features.str());
+  }
 
   auto start = std::chrono::high_resolution_clock::now();
-  auto s = lsl(G, C, L);
+  auto s     = [&]() {
+    // The grid of L is logarithmic, so it can extend to all tasks
+    if (auto_L && not cached) {
+      ThreadPool pool;
+      auto       best = auto_lookahead(
+          D,
+          W,
+          C,
+          T,
+          R,
+          D.ntasks(),
+          placement,
+          ordering,
+          reconfiguration,
+          pool);
+      L = best.second;
+      return std::move(best.first);
+    }
+    L = cached.value_or(L);
+    return lsl(D, W, C, T, R, L, placement, ordering, reconfiguration);
+  }();
   auto end = std::chrono::high_resolution_clock::now();
 
+  if (auto_L && not cached && not cache.empty()) {
+    std::ofstream out(cache, std::ios::app);
+    out << features.str() << "," << L << std::endl;
+  }
+
   auto ms =
       std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-  std::cout << "lsl," << rho << "," << boost::num_vertices(G) << "," << s.makespan() << ","
-            << ms.count() << "," << s.reconfigs.size() << "," << L << std::endl;
+  const int lower_bound =
+      lower_bounds(D, C, T, R, reconfiguration).makespan();
+  std::cout << "lsl," << rho << "," << D.ntasks() << "," << s.makespan() << ","
+            << ms.count() << "," << s.reconfigs.size() << "," << L << ","
+            << lower_bound << "," << gap(s.makespan(), lower_bound) << std::endl;
 
   json_path.replace_extension("svg");
 
-  export_svg(s, json_path.filename());
+  export_svg(s, D, json_path.filename());
 
   return 0;
 }
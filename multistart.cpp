@@ -0,0 +1,91 @@
+#include <fstream>
+#include <iostream>
+
+#include "algorithms.hpp"
+#include "race.hpp"
+#include "scheduling.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+int main(int argc, char **argv)
+{
+  int         rho       = 2;
+  size_t      K         = 16;
+  size_t      threads   = std::thread::hardware_concurrency();
+  uint64_t    seed      = 1;
+  std::string algorithm = "lsl";
+  size_t      L         = 3;
+  auto usage = []() {
+    std::cout << "Usage:" << std::endl
+              << std::endl
+              << "    multistart <inputjson>.json [rho] [K] [threads] [seed] "
+                 "[lsl|cluster|cluster-optimal] [L]"
+              << std::endl;
+    return 1;
+  };
+  if (argc < 2) {
+    std::cout << "No input file given. ";
+    return usage();
+  }
+
+  std::filesystem::path json_path(argv[1]);
+  if (argc >= 3) {
+    rho = atoi(argv[2]);
+  }
+  if (argc >= 4) {
+    K = std::max(1, atoi(argv[3]));
+  }
+  if (argc >= 5) {
+    threads = std::max(1, atoi(argv[4]));
+  }
+  if (argc >= 6) {
+    seed = std::strtoull(argv[5], nullptr, 10);
+  }
+  if (argc >= 7) {
+    algorithm = argv[6];
+    if (algorithm != "lsl" && algorithm != "cluster" &&
+        algorithm != "cluster-optimal") {
+      return usage();
+    }
+  }
+  if (argc >= 8) {
+    L = atoi(argv[7]);
+  }
+
+  // Import
+  std::ifstream  i(json_path);
+  nlohmann::json j;
+  i >> j;
+  const DAG           D(import_task_graph(j));
+  const auto          W = import_costs(j);
+  const auto          C = import_configs(j);
+  const ConfigCosts   T(W, C);
+  const ReconfigCosts R = import_reconfig_costs(j, C.size(), rho);
+  ThreadPool          pool(threads);
+
+  const auto segmentation = algorithm == "cluster-optimal"
+                                ? Segmentation::Optimal
+                                : Segmentation::Greedy;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  auto best  = multistart(D, K, seed, pool, [&](const Order &order) {
+    if (algorithm == "lsl") {
+      return lsl(D, W, C, T, R, order, L);
+    }
+    return cluster(D, W, C, T, R, order, Placement::Append, segmentation);
+  });
+  auto end   = std::chrono::high_resolution_clock::now();
+
+  const auto &s = best.first;
+  auto        us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+  std::cout << "multistart-" << algorithm << "," << rho << "," << D.ntasks()
+            << "," << s.makespan() << "," << us.count() << ","
+            << s.reconfigs.size() << "," << K << "," << pool.size() << ","
+            << best.second << std::endl;
+
+  json_path.replace_extension("svg");
+  export_svg(s, D, json_path.filename());
+
+  return 0;
+}
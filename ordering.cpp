@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <random>
+
+#include "ordering.hpp"
+
+std::optional<Ordering> parse_ordering(const std::string &name)
+{
+  if (name == "topological") {
+    return Ordering::Topological;
+  }
+  else if (name == "critical-path") {
+    return Ordering::CriticalPath;
+  }
+  else if (name == "bottom-level") {
+    return Ordering::BottomLevel;
+  }
+  else if (name == "affinity") {
+    return Ordering::Affinity;
+  }
+  else if (name == "level") {
+    return Ordering::Level;
+  }
+  return std::nullopt;
+}
+
+std::pmr::vector<int64_t> mean_costs(
+    const DAG &g, const ConfigCosts &T, std::pmr::memory_resource *mem)
+{
+  std::pmr::vector<int64_t> cost(g.ntasks(), 0, mem);
+  for (size_t v = 0; v < g.ntasks(); v++) {
+    int64_t sum        = 0;
+    int64_t supporting = 0;
+    for (size_t c = 0; c < T.nconfigs(); c++) {
+      if (T.supports(v, c)) {
+        sum += T.min_cost(v, c);
+        supporting++;
+      }
+    }
+    cost[v] = supporting ? sum / supporting : 0;
+  }
+  return cost;
+}
+
+std::pmr::vector<int64_t> upward_ranks(
+    const DAG &g, const ConfigCosts &T, std::pmr::memory_resource *mem)
+{
+  auto rank = mean_costs(g, T, mem);
+
+  // Successors come later in the topological order, so walk it backwards
+  const auto &sorted_g = g.order();
+  for (auto it = sorted_g.rbegin(); it != sorted_g.rend(); ++it) {
+    int64_t succ_rank = 0;
+    for (auto succ : g.succs(*it)) {
+      succ_rank = std::max(succ_rank, rank[succ]);
+    }
+    rank[*it] += succ_rank;
+  }
+  return rank;
+}
+
+namespace {
+
+// Kahn's algorithm which always takes the ready task for which higher()
+// returns true against all other ready tasks
+template <typename Higher>
+Order list_order(
+    const DAG &g, Higher higher, std::pmr::memory_resource *mem)
+{
+  const size_t               n = g.ntasks();
+  std::pmr::vector<uint32_t> waiting(n, 0, mem);
+  std::pmr::vector<Vertex>   ready(mem);
+  std::pmr::vector<Vertex>   order(mem);
+  ready.reserve(n);
+  order.reserve(n);
+
+  // std::push_heap keeps the largest element at the front
+  auto lower = [&](const Vertex lhs, const Vertex rhs) {
+    return higher(rhs, lhs);
+  };
+  for (auto v : g.order()) {
+    waiting[v] = g.preds(v).size();
+    if (waiting[v] == 0) {
+      ready.push_back(v);
+      std::push_heap(ready.begin(), ready.end(), lower);
+    }
+  }
+  while (not ready.empty()) {
+    std::pop_heap(ready.begin(), ready.end(), lower);
+    order.push_back(ready.back());
+    ready.pop_back();
+    for (auto succ : g.succs(order.back())) {
+      if (--waiting[succ] == 0) {
+        ready.push_back(succ);
+        std::push_heap(ready.begin(), ready.end(), lower);
+      }
+    }
+  }
+  assert(order.size() == n);
+  return order;
+}
+
+// Ready tasks are kept in one heap per cheapest configuration and in a
+// global heap. Tasks taken from one heap stay in the other and are skipped
+// there once they come up.
+Order affinity_order(
+    const DAG                       &g,
+    const ConfigCosts               &T,
+    const std::pmr::vector<int64_t> &rank,
+    const std::pmr::vector<size_t>  &position,
+    std::pmr::memory_resource       *mem)
+{
+  const size_t n  = g.ntasks();
+  const size_t nc = T.nconfigs();
+
+  auto lower = [&](const Vertex lhs, const Vertex rhs) {
+    if (rank[lhs] != rank[rhs]) {
+      return rank[lhs] < rank[rhs];
+    }
+    return position[lhs] > position[rhs];
+  };
+
+  std::pmr::vector<size_t> cheapest(n, 0, mem);
+  for (size_t v = 0; v < n; v++) {
+    for (size_t c = 1; c < nc; c++) {
+      if (T.min_cost(v, c) < T.min_cost(v, cheapest[v])) {
+        cheapest[v] = c;
+      }
+    }
+  }
+
+  std::pmr::vector<uint32_t>                 waiting(n, 0, mem);
+  std::pmr::vector<bool>                     done(n, false, mem);
+  std::pmr::vector<Vertex>                   ready(mem);
+  std::pmr::vector<std::pmr::vector<Vertex>> config_ready(nc, mem);
+  std::pmr::vector<Vertex>                   order(mem);
+  ready.reserve(n);
+  order.reserve(n);
+
+  auto push = [&](const Vertex v) {
+    ready.push_back(v);
+    std::push_heap(ready.begin(), ready.end(), lower);
+    auto &heap = config_ready[cheapest[v]];
+    heap.push_back(v);
+    std::push_heap(heap.begin(), heap.end(), lower);
+  };
+  auto pop = [&](std::pmr::vector<Vertex> &heap) {
+    std::pop_heap(heap.begin(), heap.end(), lower);
+    const Vertex v = heap.back();
+    heap.pop_back();
+    return v;
+  };
+
+  for (auto v : g.order()) {
+    waiting[v] = g.preds(v).size();
+    if (waiting[v] == 0) {
+      push(v);
+    }
+  }
+
+  size_t current = nc;
+  while (order.size() < n) {
+    auto &heap = config_ready[current == nc ? 0 : current];
+    while (current != nc && not heap.empty() && done[heap.front()]) {
+      pop(heap);
+    }
+    Vertex next;
+    if (current != nc && not heap.empty()) {
+      next = pop(heap);
+    }
+    else {
+      do {
+        next = pop(ready);
+      } while (done[next]);
+      current = cheapest[next];
+    }
+    done[next] = true;
+    order.push_back(next);
+    for (auto succ : g.succs(next)) {
+      if (--waiting[succ] == 0) {
+        push(succ);
+      }
+    }
+  }
+  return order;
+}
+
+// Uniform integer in [0, n) by Lemire's multiply and reject method. Unlike
+// std::uniform_int_distribution, the result only depends on the generator,
+// so the same seed gives the same value with any standard library.
+uint64_t bounded(std::mt19937_64 &random, uint64_t n)
+{
+  unsigned __int128 product = static_cast<unsigned __int128>(random()) * n;
+  uint64_t          low     = static_cast<uint64_t>(product);
+  if (low < n) {
+    const uint64_t threshold = -n % n;
+    while (low < threshold) {
+      product = static_cast<unsigned __int128>(random()) * n;
+      low     = static_cast<uint64_t>(product);
+    }
+  }
+  return static_cast<uint64_t>(product >> 64);
+}
+
+} // namespace
+
+Order priority_order(
+    const DAG                 &g,
+    const ConfigCosts         &T,
+    Ordering                   ordering,
+    std::pmr::memory_resource *mem)
+{
+  const auto  &sorted_g = g.order();
+  const size_t n        = sorted_g.size();
+
+  if (ordering == Ordering::Topological) {
+    return Order(sorted_g.begin(), sorted_g.end(), mem);
+  }
+
+  // Position in the topological order breaks all ties
+  std::pmr::vector<size_t> position(n, 0, mem);
+  for (size_t i = 0; i < n; i++) {
+    position[sorted_g[i]] = i;
+  }
+
+  if (ordering == Ordering::Level) {
+    // Depth of each task, then a stable counting sort by depth
+    std::pmr::vector<size_t> depth(n, 0, mem);
+    std::pmr::vector<size_t> start(n + 1, 0, mem);
+    for (auto v : sorted_g) {
+      for (auto pred : g.preds(v)) {
+        depth[v] = std::max(depth[v], depth[pred] + 1);
+      }
+      start[depth[v] + 1]++;
+    }
+    std::partial_sum(start.begin(), start.end(), start.begin());
+    Order order(n, 0, mem);
+    for (auto v : sorted_g) {
+      order[start[depth[v]]++] = v;
+    }
+    return order;
+  }
+
+  const auto rank = upward_ranks(g, T, mem);
+
+  if (ordering == Ordering::Affinity) {
+    return affinity_order(g, T, rank, position, mem);
+  }
+
+  if (ordering == Ordering::CriticalPath) {
+    // Top level: the longest path from any source to the task, excluding
+    // the task itself
+    const auto                cost = mean_costs(g, T, mem);
+    std::pmr::vector<int64_t> top(n, 0, mem);
+    for (auto v : sorted_g) {
+      for (auto pred : g.preds(v)) {
+        top[v] = std::max(top[v], top[pred] + cost[pred]);
+      }
+    }
+    return list_order(
+        g,
+        [&](const Vertex lhs, const Vertex rhs) {
+          const int64_t path_lhs = top[lhs] + rank[lhs];
+          const int64_t path_rhs = top[rhs] + rank[rhs];
+          if (path_lhs != path_rhs) {
+            return path_lhs > path_rhs;
+          }
+          if (rank[lhs] != rank[rhs]) {
+            return rank[lhs] > rank[rhs];
+          }
+          return position[lhs] < position[rhs];
+        },
+        mem);
+  }
+
+  assert(ordering == Ordering::BottomLevel);
+  return list_order(
+      g,
+      [&](const Vertex lhs, const Vertex rhs) {
+        if (rank[lhs] != rank[rhs]) {
+          return rank[lhs] > rank[rhs];
+        }
+        return position[lhs] < position[rhs];
+      },
+      mem);
+}
+
+Order random_order(const DAG &g, uint64_t seed, std::pmr::memory_resource *mem)
+{
+  const size_t               n = g.ntasks();
+  std::pmr::vector<uint32_t> waiting(n, 0, mem);
+  Order                      ready(mem);
+  Order                      order(mem);
+  ready.reserve(n);
+  order.reserve(n);
+
+  for (auto v : g.order()) {
+    waiting[v] = g.preds(v).size();
+    if (waiting[v] == 0) {
+      ready.push_back(v);
+    }
+  }
+
+  std::mt19937_64 random(seed);
+  while (not ready.empty()) {
+    std::swap(ready[bounded(random, ready.size())], ready.back());
+    order.push_back(ready.back());
+    ready.pop_back();
+    for (auto succ : g.succs(order.back())) {
+      if (--waiting[succ] == 0) {
+        ready.push_back(succ);
+      }
+    }
+  }
+  assert(order.size() == n);
+  return order;
+}
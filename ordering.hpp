@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "dag.hpp"
+#include "scheduling.hpp"
+
+// Order in which lsl() and cluster() visit the tasks. All orderings are
+// topological, i.e. every task comes after its predecessors.
+//
+//  - Topological: the order of DAG::order()
+//  - CriticalPath: ready tasks with the longest path through them first
+//  - BottomLevel: ready tasks with the highest upward rank first
+//  - Affinity: ready tasks whose cheapest configuration is the one of the
+//    previous task first, then by upward rank
+//  - Level: by depth in the DAG, i.e. breadth first
+enum class Ordering { Topological, CriticalPath, BottomLevel, Affinity, Level };
+
+using Order = std::pmr::vector<Vertex>;
+
+std::optional<Ordering> parse_ordering(const std::string &name);
+
+Order priority_order(
+    const DAG                 &g,
+    const ConfigCosts         &T,
+    Ordering                   ordering,
+    std::pmr::memory_resource *mem = std::pmr::get_default_resource());
+
+// Uniformly random choice among the ready tasks in each step of Kahn's
+// algorithm. The same seed gives the same order on any platform.
+Order random_order(
+    const DAG                 &g,
+    uint64_t                   seed,
+    std::pmr::memory_resource *mem = std::pmr::get_default_resource());
+
+// Mean min cost of each task over the configurations which support it
+std::pmr::vector<int64_t> mean_costs(
+    const DAG                 &g,
+    const ConfigCosts         &T,
+    std::pmr::memory_resource *mem = std::pmr::get_default_resource());
+
+// Upward rank (bottom level) of each task: its mean cost plus the largest
+// upward rank of its successors, indexed by vertex
+std::pmr::vector<int64_t> upward_ranks(
+    const DAG                 &g,
+    const ConfigCosts         &T,
+    std::pmr::memory_resource *mem = std::pmr::get_default_resource());
@@ -0,0 +1,105 @@
+#include <fstream>
+#include <iostream>
+
+#include "algorithms.hpp"
+#include "race.hpp"
+#include "scheduling.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+int main(int argc, char **argv)
+{
+  int       rho             = 2;
+  size_t    threads         = std::thread::hardware_concurrency();
+  Placement placement       = Placement::Append;
+  auto      reconfiguration = Reconfiguration::Global;
+  if (argc < 2) {
+    std::cout << "No input file given. Usage:" << std::endl
+              << std::endl
+              << "    portfolio <inputjson>.json [rho] [threads] "
+                 "[append|insertion] [global|partial]"
+              << std::endl;
+    return 1;
+  }
+
+  std::filesystem::path json_path(argv[1]);
+  if (argc >= 3) {
+    rho = atoi(argv[2]);
+  }
+  if (argc >= 4) {
+    threads = std::max(1, atoi(argv[3]));
+  }
+  for (int arg = 4; arg < argc; arg++) {
+    if (std::string(argv[arg]) == "insertion") {
+      placement = Placement::Insertion;
+    }
+    else if (std::string(argv[arg]) == "partial") {
+      reconfiguration = Reconfiguration::Partial;
+    }
+  }
+
+  // Import once, all members share the problem
+  std::ifstream  i(json_path);
+  nlohmann::json j;
+  i >> j;
+  const DAG           D(import_task_graph(j));
+  const auto          W = import_costs(j);
+  const auto          C = import_configs(j);
+  const ConfigCosts   T(W, C);
+  const ReconfigCosts R = import_reconfig_costs(j, C.size(), rho);
+  ThreadPool          pool(threads);
+
+  auto *heap    = std::pmr::get_default_resource();
+  auto  run_lsl = [&](size_t L, Ordering ordering) {
+    return [&, L, ordering]() {
+      return lsl(
+          D, W, C, T, R, L, placement, ordering, reconfiguration, heap, &pool);
+    };
+  };
+  auto run_cluster = [&](Segmentation segmentation, Ordering ordering) {
+    return [&, segmentation, ordering]() {
+      return cluster(
+          D, W, C, T, R, placement, segmentation, ordering, reconfiguration);
+    };
+  };
+
+  const std::vector<Member> members = {
+      {"lsl-1", run_lsl(1, Ordering::Topological)},
+      {"lsl-3", run_lsl(3, Ordering::Topological)},
+      {"lsl-10", run_lsl(10, Ordering::Topological)},
+      {"lsl-30", run_lsl(30, Ordering::Topological)},
+      {"lsl-affinity-10", run_lsl(10, Ordering::Affinity)},
+      {"cluster", run_cluster(Segmentation::Greedy, Ordering::Topological)},
+      {"cluster-bottom-level",
+       run_cluster(Segmentation::Greedy, Ordering::BottomLevel)},
+      {"cluster-optimal",
+       run_cluster(Segmentation::Optimal, Ordering::Topological)},
+      {"cluster-optimal-bottom-level",
+       run_cluster(Segmentation::Optimal, Ordering::BottomLevel)},
+      {"heft", [&]() {
+         return heft(D, W, C, T, R, placement, reconfiguration);
+       }}};
+
+  auto start   = std::chrono::high_resolution_clock::now();
+  auto results = race(members, pool);
+  auto end     = std::chrono::high_resolution_clock::now();
+
+  for (const auto &result : results) {
+    std::cout << result.name << "," << rho << "," << D.ntasks() << ","
+              << result.schedule.makespan() << "," << result.time.count()
+              << "," << result.schedule.reconfigs.size() << std::endl;
+  }
+
+  const auto &winner = results[best(results)];
+  auto        us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+  std::cout << "portfolio," << rho << "," << D.ntasks() << ","
+            << winner.schedule.makespan() << "," << us.count() << ","
+            << winner.schedule.reconfigs.size() << "," << winner.name
+            << std::endl;
+
+  json_path.replace_extension("svg");
+  export_svg(winner.schedule, D, json_path.filename());
+
+  return 0;
+}
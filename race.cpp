@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cassert>
+#include <future>
+#include <mutex>
+#include <optional>
+
+#include "race.hpp"
+
+std::vector<Result> race(const std::vector<Member> &members, ThreadPool &pool)
+{
+  std::vector<std::future<Result>> pending;
+  pending.reserve(members.size());
+  for (const auto &member : members) {
+    pending.push_back(pool.submit([&member]() {
+      auto start    = std::chrono::high_resolution_clock::now();
+      auto schedule = member.run();
+      auto end      = std::chrono::high_resolution_clock::now();
+      return Result{
+          member.name,
+          std::move(schedule),
+          std::chrono::duration_cast<std::chrono::microseconds>(end - start)};
+    }));
+  }
+
+  std::vector<Result> results;
+  results.reserve(members.size());
+  for (auto &result : pending) {
+    results.push_back(result.get());
+  }
+  return results;
+}
+
+size_t best(const std::vector<Result> &results)
+{
+  assert(!results.empty());
+  auto min = std::min_element(
+      results.begin(), results.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.schedule.makespan() < rhs.schedule.makespan();
+      });
+  return std::distance(results.begin(), min);
+}
+
+std::pair<Schedule, size_t> multistart(
+    const DAG                                    &g,
+    size_t                                        K,
+    uint64_t                                      seed,
+    ThreadPool                                   &pool,
+    const std::function<Schedule(const Order &)> &schedule)
+{
+  assert(K > 0);
+
+  std::mutex              mutex;
+  std::optional<Schedule> best_schedule;
+  size_t                  best_k = K;
+
+  // Every start builds its own order and Schedule, only the best one is kept
+  pool.parallel_for(0, K, [&](size_t k) {
+    auto S = schedule(random_order(g, seed + k));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (not best_schedule || S.makespan() < best_schedule->makespan() ||
+        (S.makespan() == best_schedule->makespan() && k < best_k)) {
+      best_schedule.emplace(std::move(S));
+      best_k = k;
+    }
+  });
+
+  return std::make_pair(std::move(*best_schedule), best_k);
+}
+
+std::pair<Schedule, size_t> auto_lookahead(
+    const DAG            &g,
+    const CostMatrix     &W,
+    const Configurations &C,
+    const ConfigCosts    &T,
+    const ReconfigCosts  &R,
+    size_t                max_L,
+    Placement             placement,
+    Ordering              ordering,
+    Reconfiguration       reconfiguration,
+    ThreadPool           &pool)
+{
+  const Order order = priority_order(g, T, ordering);
+
+  // Powers of two and the halfway values 3 * 2^k, i.e. 1, 2, 3, 4, 6, 8, 12
+  std::vector<size_t> Ls;
+  for (size_t L = 1; L <= std::min(max_L, g.ntasks()); L *= 2) {
+    Ls.push_back(L);
+    if (L > 1 && L + L / 2 <= std::min(max_L, g.ntasks())) {
+      Ls.push_back(L + L / 2);
+    }
+  }
+
+  std::vector<Member> members;
+  for (auto L : Ls) {
+    members.push_back(Member{"lsl-" + std::to_string(L), [&, L]() {
+                               return lsl(
+                                   g,
+                                   W,
+                                   C,
+                                   T,
+                                   R,
+                                   order,
+                                   L,
+                                   placement,
+                                   reconfiguration);
+                             }});
+  }
+  auto         results = race(members, pool);
+  const size_t winner  = best(results);
+  return std::make_pair(std::move(results[winner].schedule), Ls[winner]);
+}
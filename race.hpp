@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "algorithms.hpp"
+#include "dag.hpp"
+#include "ordering.hpp"
+#include "scheduling.hpp"
+#include "thread_pool.hpp"
+
+// A scheduler of a portfolio. All members share the same read-only problem
+// and must not modify it, since they run concurrently.
+struct Member {
+  std::string               name;
+  std::function<Schedule()> run;
+};
+
+struct Result {
+  std::string               name;
+  Schedule                  schedule;
+  std::chrono::microseconds time;
+};
+
+// Runs all members concurrently on the pool and returns their results in the
+// order of the members
+std::vector<Result> race(const std::vector<Member> &members, ThreadPool &pool);
+
+// Index of the result with the lowest makespan, the first one on ties
+size_t best(const std::vector<Result> &results);
+
+// Schedules K random topological orders of g, the k-th generated from
+// seed + k, concurrently on the pool. Returns the schedule with the lowest
+// makespan (the lowest k on ties) and its k, so the result only depends on
+// seed and K and not on the number of threads.
+std::pair<Schedule, size_t> multistart(
+    const DAG                                    &g,
+    size_t                                        K,
+    uint64_t                                      seed,
+    ThreadPool                                   &pool,
+    const std::function<Schedule(const Order &)> &schedule);
+
+// Runs lsl() with the lookaheads 1, 2, 3, 4, 6, 8, 12, ... up to max_L
+// concurrently on the pool, all on one priority order of g. Returns the
+// schedule with the lowest makespan and its L, the smallest L on ties.
+std::pair<Schedule, size_t> auto_lookahead(
+    const DAG            &g,
+    const CostMatrix     &W,
+    const Configurations &C,
+    const ConfigCosts    &T,
+    const ReconfigCosts  &R,
+    size_t                max_L,
+    Placement             placement,
+    Ordering              ordering,
+    Reconfiguration       reconfiguration,
+    ThreadPool           &pool);
@@ -3,8 +3,6 @@
 #include "scheduling.hpp"
 #include "boost/graph/topological_sort.hpp"
 
-extern int rho;
-
 PE::PE(size_t o)
   : offset(o)
 {
@@ -15,10 +13,38 @@ bool PE::operator==(const PE &other) const
   return offset == other.offset;
 }
 
-std::optional<int> TaskV::cost(PE p) const
+CostMatrix::CostMatrix(size_t ntasks, size_t npes)
+  : _npes(npes)
+  , _cost(ntasks * npes, Unsupported)
 {
-  return _cost[p.offset];
-};
+}
+
+size_t CostMatrix::ntasks() const
+{
+  return _npes > 0 ? _cost.size() / _npes : 0;
+}
+
+size_t CostMatrix::npes() const
+{
+  return _npes;
+}
+
+int CostMatrix::cost(Vertex v, const PE &p) const
+{
+  assert(p.offset < _npes);
+  return _cost[v * _npes + p.offset];
+}
+
+bool CostMatrix::supports(Vertex v, const PE &p) const
+{
+  return cost(v, p) != Unsupported;
+}
+
+void CostMatrix::set_cost(Vertex v, const PE &p, int cost)
+{
+  assert(p.offset < _npes);
+  _cost[v * _npes + p.offset] = cost;
+}
 
 Configuration::Configuration(const std::string &n)
   : name(n)
@@ -30,55 +56,49 @@ bool Configuration::operator==(const Configuration &other) const
   return name == other.name;
 }
 
-PE Configuration::optimal_pe(const TaskV &v) const
+// Unsupported is the largest int, so unsupported PEs are only chosen if no PE
+// of this configuration supports v.
+PE Configuration::optimal_pe(const CostMatrix &W, Vertex v) const
 {
-  auto opt = std::min_element(
-      pes.begin(), pes.end(), [&v](const auto lhs, const auto rhs) {
-        // Note: operator<() does the exact oposite of this if one value is
-        // missing. We want it to be +infty while since C++17 the missing
-        // value is considered -infty.
-        const auto l = v.cost(lhs);
-        const auto r = v.cost(rhs);
-        if (l && r) {
-          return l.value() < r.value();
-        }
-        else if (l) {
-          return true;
-        }
-        else {
-          return false;
-        }
-      });
-  return *opt;
+  assert(!pes.empty());
+  auto opt      = pes.front();
+  int  opt_cost = W.cost(v, opt);
+  for (const auto &pe : pes) {
+    const int cost = W.cost(v, pe);
+    if (cost < opt_cost) {
+      opt      = pe;
+      opt_cost = cost;
+    }
+  }
+  return opt;
 }
 
-std::optional<int> Configuration::min_cost(const TaskV &v) const
+std::optional<int> Configuration::min_cost(const CostMatrix &W, Vertex v) const
 {
-  auto opt_pe = optimal_pe(v);
-  return v.cost(opt_pe);
+  int min = CostMatrix::Unsupported;
+  for (const auto &pe : pes) {
+    min = std::min(min, W.cost(v, pe));
+  }
+  if (min == CostMatrix::Unsupported) {
+    return std::optional<int>{};
+  }
+  return std::optional<int>(min);
 }
 
 // divide the cost by all available PEs (average / num_avail_pe)
-std::optional<int> Configuration::divided_cost(const TaskV &v) const
-{
-  auto sum = std::accumulate(
-      pes.begin(),
-      pes.end(),
-      0,
-      [&v](const auto acc, const auto pe) {
-        auto cost = v.cost(pe);
-        if (cost) {
-          return acc + cost.value();
-        }
-        else {
-          return acc;
-        }
-      });
-
-  auto count = std::count_if(pes.begin(), pes.end(), [&v](const auto pe) {
-    return static_cast<bool>(v.cost(pe).has_value());
-  });
-  
+std::optional<int> Configuration::divided_cost(
+    const CostMatrix &W, Vertex v) const
+{
+  int sum   = 0;
+  int count = 0;
+  for (const auto &pe : pes) {
+    const int cost = W.cost(v, pe);
+    if (cost != CostMatrix::Unsupported) {
+      sum += cost;
+      count++;
+    }
+  }
+
   if (count > 0) {
     return std::optional<int>(sum / count / count);
   } else {
@@ -91,19 +111,175 @@ void Configuration::add_pe(size_t offset)
   pes.emplace_back(offset);
 }
 
-Schedule::Schedule(const Configurations &C)
-  : confs(C)
+ConfigCosts::ConfigCosts(const CostMatrix &W, const Configurations &C)
+  : _nconfigs(C.size())
+  , _min_cost(W.ntasks() * C.size(), CostMatrix::Unsupported)
+  , _optimal_pe(W.ntasks() * C.size(), 0)
+  , _divided_cost(W.ntasks() * C.size(), CostMatrix::Unsupported)
 {
-  for (auto c : confs) {
-    for (auto &pe : c.pes) {
-      pe_t_f[pe] = 0;
+  for (size_t v = 0; v < W.ntasks(); v++) {
+    for (size_t c = 0; c < C.size(); c++) {
+      const size_t i = v * _nconfigs + c;
+      if (C[c].pes.empty()) {
+        continue;
+      }
+      _optimal_pe[i]   = C[c].optimal_pe(W, v).offset;
+      _min_cost[i]     = C[c].min_cost(W, v).value_or(CostMatrix::Unsupported);
+      _divided_cost[i] =
+          C[c].divided_cost(W, v).value_or(CostMatrix::Unsupported);
     }
   }
 }
+
+size_t ConfigCosts::nconfigs() const
+{
+  return _nconfigs;
+}
+
+int ConfigCosts::min_cost(Vertex v, size_t c) const
+{
+  return _min_cost[v * _nconfigs + c];
+}
+
+PE ConfigCosts::optimal_pe(Vertex v, size_t c) const
+{
+  return PE(_optimal_pe[v * _nconfigs + c]);
+}
+
+int ConfigCosts::divided_cost(Vertex v, size_t c) const
+{
+  return _divided_cost[v * _nconfigs + c];
+}
+
+bool ConfigCosts::supports(Vertex v, size_t c) const
+{
+  return min_cost(v, c) != CostMatrix::Unsupported;
+}
+
+ReconfigCosts::ReconfigCosts(size_t nconfigs, int rho)
+  : _nconfigs(nconfigs)
+  , _cost(nconfigs * nconfigs, rho)
+  , _initial(nconfigs, rho)
+{
+  for (size_t c = 0; c < nconfigs; c++) {
+    _cost[c * nconfigs + c] = 0;
+  }
+}
+
+size_t ReconfigCosts::nconfigs() const
+{
+  return _nconfigs;
+}
+
+int ReconfigCosts::cost(size_t from, size_t to) const
+{
+  assert(to < _nconfigs);
+  if (from >= _nconfigs) {
+    return _initial[to];
+  }
+  return _cost[from * _nconfigs + to];
+}
+
+void ReconfigCosts::set_cost(size_t from, size_t to, int cost)
+{
+  _cost[from * _nconfigs + to] = cost;
+}
+
+void ReconfigCosts::set_initial(size_t to, int cost)
+{
+  _initial[to] = cost;
+}
+
+IdleIntervals::IdleIntervals(std::pmr::memory_resource *mem)
+  : intervals(mem)
+{
+  // PEs are idle from the first time step onwards
+  intervals.emplace(1, Open);
+}
+
+// Earliest start time >= ready at which a task of the given cost fits into an
+// idle interval. This is a O(log n) lookup of the first interval ending after
+// ready, followed by a walk over the intervals that are too short.
+int IdleIntervals::earliest_fit(int ready, int cost) const
+{
+  auto it = intervals.upper_bound(ready);
+  if (it != intervals.begin() && std::prev(it)->second >= ready) {
+    --it;
+  }
+
+  for (; it != intervals.end(); ++it) {
+    const int t_s = std::max(it->first, ready);
+    if (it->second - t_s >= cost) {
+      return t_s;
+    }
+  }
+
+  // The last interval is open, so this is only reached if ready lies after
+  // all intervals
+  assert(false);
+  return ready;
+}
+
+void IdleIntervals::reserve(int t_s, int t_f)
+{
+  auto it = std::prev(intervals.upper_bound(t_s));
+  assert(it->first <= t_s && t_f <= it->second);
+
+  const int start = it->first;
+  const int end   = it->second;
+  intervals.erase(it);
+  if (start < t_s) {
+    intervals.emplace(start, t_s - 1);
+  }
+  if (t_f < end) {
+    intervals.emplace(t_f + 1, end);
+  }
+}
+
+Schedule::Schedule(
+    const Configurations      &C,
+    const CostMatrix          &costs,
+    Placement                  p,
+    std::pmr::memory_resource *mem)
+  : scheduled_tasks(mem)
+  , confs(std::addressof(C))
+  , W(std::addressof(costs))
+  , placement(p)
+  , reconfigs(mem)
+  , reconfig_costs(mem)
+  , reconfig_regions(mem)
+  , pe_t_f(W->npes(), 0, mem)
+  , pe_tasks(W->npes(), mem)
+  , pe_config(W->npes(), NoConfig, mem)
+  , task_t_f(costs.ntasks(), -1, mem)
+  , pe_idle(mem)
+  , pe_region(W->npes(), NoRegion, mem)
+  , region_config(mem)
+  , region_t_f(mem)
+{
+  scheduled_tasks.reserve(costs.ntasks());
+
+  if (placement == Placement::Insertion) {
+    pe_idle.reserve(W->npes());
+    for (size_t pe = 0; pe < W->npes(); pe++) {
+      pe_idle.emplace_back(mem);
+    }
+  }
+
+  size_t nregions = 0;
+  for (size_t c = 0; c < confs->size(); c++) {
+    for (size_t k = 0; k < (*confs)[c].pes.size(); k++) {
+      pe_config[(*confs)[c].pes[k].offset] = c;
+      pe_region[(*confs)[c].pes[k].offset] = k;
+    }
+    nregions = std::max(nregions, (*confs)[c].pes.size());
+  }
+  region_config.assign(nregions, NoConfig);
+  region_t_f.assign(nregions, 0);
+}
 int Schedule::ScheduledTask::cost() const
 {
-  assert(task.cost(p));
-  return task.cost(p).value();
+  return _cost;
 }
 int Schedule::ScheduledTask::t_f() const
 {
@@ -112,15 +288,7 @@ int Schedule::ScheduledTask::t_f() const
 
 int Schedule::makespan() const
 {
-  auto max_pe = std::max_element(
-      pe_t_f.begin(), pe_t_f.end(), [](const auto lhs, const auto rhs) {
-        return lhs.second < rhs.second;
-      });
-  if (max_pe == pe_t_f.end()) {
-    return 0;
-  }
-
-  return max_pe->second;
+  return max_pe_t_f;
 }
 
 int Schedule::ScheduledTask::t_s() const
@@ -132,56 +300,66 @@ PE Schedule::ScheduledTask::pe() const
 {
   return p;
 };
-TaskV Schedule::ScheduledTask::vertex() const {
+Vertex Schedule::ScheduledTask::vertex() const {
   return task;
 }
 
 int Schedule::max_t_f(const PE &p) const
 {
-  if (pe_t_f.count(p) > 0) {
-    return pe_t_f.find(p)->second;
+  if (p.offset < pe_t_f.size()) {
+    return pe_t_f[p.offset];
   } else {
     return 0;
   }
 }
 
-std::pair<PE, int> Schedule::earliest_finish(const TaskV &v)
+// Returns the first PE in [first, last) on which v finishes earliest when
+// appended to the PE. PEs which cannot execute v are considered to finish at
+// +infty.
+template <typename PEIt>
+PEIt Schedule::earliest_pe(PEIt first, PEIt last, Vertex v) const
 {
-  auto min = std::min_element(
-      pe_t_f.begin(), pe_t_f.end(), [&](const auto &lhs, const auto &rhs) {
-        auto lhs_cost = v.cost(lhs.first);
-        auto rhs_cost = v.cost(rhs.first);
+  auto min     = first;
+  int  min_t_f = std::numeric_limits<int>::max();
+  for (auto it = first; it != last; ++it) {
+    const int cost = W->cost(v, *it);
+    const int t_f  = cost != CostMatrix::Unsupported
+                         ? pe_t_f[it->offset] + cost
+                         : std::numeric_limits<int>::max();
+    if (t_f < min_t_f) {
+      min     = it;
+      min_t_f = t_f;
+    }
+  }
+  return min;
+}
 
-        if(lhs_cost && rhs_cost) {
-          return lhs_cost.value() < rhs_cost.value();
-        } else if (lhs_cost) {
-          return true;
-        }
-        return false;
-      });
+std::pair<PE, int> Schedule::earliest_finish(Vertex v)
+{
+  std::optional<PE> min;
+  int               min_cost = CostMatrix::Unsupported;
+  for (size_t offset = 0; offset < pe_config.size(); offset++) {
+    if (pe_config[offset] == NoConfig) {
+      continue;
+    }
+    const int cost = W->cost(v, PE(offset));
+    if (!min || cost < min_cost) {
+      min      = PE(offset);
+      min_cost = cost;
+    }
+  }
 
-  assert(min != pe_t_f.end());
-  assert(v.cost(min->first));
+  assert(min);
+  assert(W->supports(v, *min));
 
-  return std::make_pair(min->first, min->second + v.cost(min->first).value());
+  return std::make_pair(*min, pe_t_f[min->offset] + min_cost);
 }
 
-std::pair<PE, int> Schedule::asap(const Configuration &C, const TaskV &v)
+std::pair<PE, int> Schedule::asap(const Configuration &C, Vertex v)
 {
-  auto min = std::min_element(
-      C.pes.begin(), C.pes.end(), [&v,this](const auto &lhs, const auto &rhs) {
-        auto lhs_cost = v.cost(lhs);
-        auto rhs_cost = v.cost(rhs);
+  auto min = earliest_pe(C.pes.begin(), C.pes.end(), v);
 
-        if(lhs_cost && rhs_cost) {
-          return pe_t_f[lhs] + lhs_cost.value() < pe_t_f[rhs] + rhs_cost.value();
-        } else if (lhs_cost) {
-          return true;
-        }
-        return false;
-      });
-
-  auto t_s = pe_t_f[*min] + 1;
+  auto t_s = pe_t_f[min->offset] + 1;
   if(not reconfigs.empty()) {
     t_s = std::max(reconfigs.back(), t_s);
   }
@@ -189,78 +367,158 @@ std::pair<PE, int> Schedule::asap(const Configuration &C, const TaskV &v)
   return std::make_pair(*min, t_s);
 }
 
-std::pair<PE, int> Schedule::earliest_finish(const TaskV& v, const Configuration &C)
+std::pair<PE, int> Schedule::earliest_finish(Vertex v, const Configuration &C)
 {
+  auto min = earliest_pe(C.pes.begin(), C.pes.end(), v);
+
+  return std::make_pair(*min, pe_t_f[min->offset]);
+}
 
-  auto min = std::min_element(
-      C.pes.begin(), C.pes.end(), [this,&v](const auto &lhs, const auto &rhs) {
-        const auto lhs_cost = v.cost(lhs);
-        const auto rhs_cost = v.cost(rhs);
-        if(lhs_cost && rhs_cost) {
-          return lhs_cost.value() + pe_t_f[lhs] < rhs_cost.value() + pe_t_f[rhs];
-        } else if (lhs_cost) {
-          return true;
-        }
-        return false;
-      });
+// Returns the PE of C and the start time >= ready at which v finishes
+// earliest when inserted into the idle intervals of the PEs.
+std::pair<PE, int> Schedule::earliest_gap(
+    const Configuration &C, Vertex v, int ready) const
+{
+  assert(placement == Placement::Insertion);
+  assert(!C.pes.empty());
+
+  auto min     = C.pes.front();
+  int  min_t_s = ready;
+  int  min_t_f = std::numeric_limits<int>::max();
+  for (const auto &pe : C.pes) {
+    const int cost = W->cost(v, pe);
+    if (cost == CostMatrix::Unsupported) {
+      continue;
+    }
+    const int t_s = pe_idle[pe.offset].earliest_fit(ready, cost);
+    if (t_s + cost < min_t_f) {
+      min     = pe;
+      min_t_s = t_s;
+      min_t_f = t_s + cost;
+    }
+  }
+
+  return std::make_pair(min, min_t_s);
+}
+
+// Returns the PE of configuration c and the start time >= ready at which v
+// finishes earliest when the region of the PE is reconfigured on its own.
+std::pair<PE, int> Schedule::earliest_region(
+    const ReconfigCosts &R, size_t c, Vertex v, int ready) const
+{
+  const auto &C = (*confs)[c];
+  assert(!C.pes.empty());
+
+  auto min     = C.pes.front();
+  int  min_t_s = ready;
+  int  min_t_f = std::numeric_limits<int>::max();
+  for (const auto &pe : C.pes) {
+    const int cost = W->cost(v, pe);
+    if (cost == CostMatrix::Unsupported) {
+      continue;
+    }
+    const size_t k    = pe_region[pe.offset];
+    int          free = region_t_f[k];
+    if (region_config[k] != c) {
+      free += R.cost(region_config[k], c);
+    }
+    const int t_s = std::max(ready, free + 1);
+    if (t_s + cost < min_t_f) {
+      min     = pe;
+      min_t_s = t_s;
+      min_t_f = t_s + cost;
+    }
+  }
 
-  return std::make_pair(*min, pe_t_f[*min]);
+  return std::make_pair(min, min_t_s);
 }
 
+// Schedules v on p at t_s after reconfiguring the region of p if it holds
+// another configuration.
+Schedule::ScheduledTask &Schedule::schedule_on_region(
+    const ReconfigCosts &R, Vertex v, PE p, int t_s)
+{
+  const size_t k = pe_region[p.offset];
+  const size_t c = pe_config[p.offset];
+  if (region_config[k] != c) {
+    reconfigs.push_back(region_t_f[k]);
+    reconfig_costs.push_back(R.cost(region_config[k], c));
+    reconfig_regions.push_back(k);
+    region_config[k] = c;
+    region_t_f[k] += reconfig_costs.back();
+  }
+  assert(t_s > region_t_f[k]);
 
+  auto &task    = schedule_task(v, p, t_s);
+  region_t_f[k] = std::max(region_t_f[k], task.t_f());
+  return task;
+}
 
-std::vector<Schedule::ScheduledTask> Schedule::tasks_on_pe(const PE &p) const
+Schedule::Timeline Schedule::tasks_on_pe(const PE &p) const
 {
-  std::vector<ScheduledTask> t;
-  std::copy_if(
-      scheduled_tasks.begin(), scheduled_tasks.end(), std::back_inserter(t), [&](auto mtask) {
-        return mtask.pe() == p;
-      });
-  return t;
+  static const std::pmr::vector<size_t> none;
+  const auto &indices = p.offset < pe_tasks.size() ? pe_tasks[p.offset] : none;
+
+  return Timeline(
+      boost::make_permutation_iterator(
+          scheduled_tasks.begin(), indices.begin()),
+      boost::make_permutation_iterator(
+          scheduled_tasks.begin(), indices.end()));
 }
 
-Schedule::ScheduledTask &Schedule::schedule_task(TaskV v, PE p, int t_s)
+Schedule::ScheduledTask &Schedule::schedule_task(Vertex v, PE p, int t_s)
 {
-  scheduled_tasks.emplace_back(v, p, t_s);
+  scheduled_tasks.emplace_back(v, p, t_s, W->cost(v, p));
 
-  pe_t_f[p] = scheduled_tasks.back().t_f();
+  // Keep the timeline ordered by start time. Tasks are usually appended, so
+  // only search for the position if the task starts before the last one.
+  auto &timeline = pe_tasks[p.offset];
+  if (timeline.empty() || scheduled_tasks[timeline.back()].t_s() <= t_s) {
+    timeline.push_back(scheduled_tasks.size() - 1);
+  }
+  else {
+    auto pos = std::upper_bound(
+        timeline.begin(),
+        timeline.end(),
+        t_s,
+        [this](const int start, const size_t index) {
+          return start < scheduled_tasks[index].t_s();
+        });
+    timeline.insert(pos, scheduled_tasks.size() - 1);
+  }
+  if (placement == Placement::Insertion) {
+    pe_idle[p.offset].reserve(t_s, scheduled_tasks.back().t_f());
+  }
+  pe_t_f[p.offset] = std::max(pe_t_f[p.offset], scheduled_tasks.back().t_f());
+  max_pe_t_f       = std::max(max_pe_t_f, pe_t_f[p.offset]);
+  task_t_f[v] = scheduled_tasks.back().t_f();
   return scheduled_tasks.back();
 }
-Schedule::ScheduledTask &Schedule::schedule_task(TaskV v, PE p)
+Schedule::ScheduledTask &Schedule::schedule_task(Vertex v, PE p)
 {
-  auto t_s = std::max(reconfigs.back() + rho, max_t_f(p));
+  auto t_s = std::max(reconfigs.back() + reconfig_costs.back(), max_t_f(p));
   return schedule_task(v, p, t_s + 1);
 }
-int Schedule::insert_reconfiguration(int rho) {
-  int limit = 0;
-  for (auto c : confs) {
-    for (auto pe : c.pes) {
-      int max = max_t_f(pe);
-      if(max > limit) {
-        limit = max;
-      }
-    }
-  }
-  reconfigs.push_back(limit);
-  return limit + rho;
+int Schedule::insert_reconfiguration(int cost) {
+  reconfigs.push_back(max_pe_t_f);
+  reconfig_costs.push_back(cost);
+  reconfig_regions.push_back(NoRegion);
+  return max_pe_t_f + cost;
 }
-int Schedule::t_f(TaskV v)
+int Schedule::t_f(Vertex v) const
 {
-  auto task = std::find_if(scheduled_tasks.begin(), scheduled_tasks.end(), [&v](auto &task) {
-      return task.vertex().name == v.name;
-      });
-  assert(task != scheduled_tasks.end());
-  return task->t_f();
+  assert(v < task_t_f.size());
+  assert(task_t_f[v] >= 0);
+  return task_t_f[v];
 }
 
 
 std::ostream &operator<<(std::ostream &os, const Schedule &S)
 {
-  for (auto c : S.confs) {
+  for (const auto &c : *S.confs) {
     for (auto pe : c.pes) {
-      auto tasks = S.tasks_on_pe(pe);
-      for (auto t : tasks) {
-        os << "[" << t.t_s() << "-" << t.t_f() << "] " << t.vertex().name << std::endl;
+      for (const auto &t : S.tasks_on_pe(pe)) {
+        os << "[" << t.t_s() << "-" << t.t_f() << "] " << t.vertex() << std::endl;
       }
       os << std::endl;
     }
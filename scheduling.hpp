@@ -2,14 +2,16 @@
 
 #include <stddef.h>
 #include <vector>
-#include <unordered_map>
+#include <limits>
+#include <map>
+#include <memory_resource>
 #include <optional>
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/subgraph.hpp>
-
-constexpr size_t MaxPE = 7;
+#include <boost/iterator/permutation_iterator.hpp>
+#include <boost/range/iterator_range.hpp>
 
 class PE {
   public:
@@ -18,20 +20,37 @@ class PE {
   explicit PE(size_t o);
 
   bool operator==(const PE &other) const;
-
-  struct Hash {
-    std::size_t operator()(const PE &p) const noexcept
-    {
-      return p.offset;
-    }
-  };
 };
 
 struct TaskV {
-  std::string            name;
-  std::array<std::optional<int>, MaxPE> _cost;
+  std::string name;
+};
+
+using Graph  = boost::subgraph<boost::adjacency_list<
+    boost::vecS,
+    boost::vecS,
+    boost::bidirectionalS,
+    TaskV,
+    boost::property<boost::edge_index_t, int>>>;
+using Vertex = Graph::vertex_descriptor;
+
+// Cost of each task on each PE, stored row-major (one row of PEs per task).
+// Tasks which cannot be executed on a PE have the cost Unsupported.
+class CostMatrix {
+  public:
+  static constexpr int Unsupported = std::numeric_limits<int>::max();
+
+  CostMatrix(size_t ntasks, size_t npes);
+
+  size_t ntasks() const;
+  size_t npes() const;
+  int    cost(Vertex v, const PE &p) const;
+  bool   supports(Vertex v, const PE &p) const;
+  void   set_cost(Vertex v, const PE &p, int cost);
 
-  std::optional<int> cost(PE p) const;
+  private:
+  size_t           _npes;
+  std::vector<int> _cost;
 };
 
 struct Configuration {
@@ -40,9 +59,9 @@ struct Configuration {
 
   explicit Configuration(const std::string &n);
   bool               operator==(const Configuration &other) const;
-  PE                 optimal_pe(const TaskV &v) const;
-  std::optional<int> min_cost(const TaskV &v) const;
-  std::optional<int> divided_cost(const TaskV &v) const;
+  PE                 optimal_pe(const CostMatrix &W, Vertex v) const;
+  std::optional<int> min_cost(const CostMatrix &W, Vertex v) const;
+  std::optional<int> divided_cost(const CostMatrix &W, Vertex v) const;
   void               add_pe(size_t offset);
 };
 using Configurations = std::vector<Configuration>;
@@ -50,53 +69,160 @@ using Configurations = std::vector<Configuration>;
 // Mapping of PE[n] to config
 using PEs = std::vector<PE>;
 
-using Graph  = boost::subgraph<boost::adjacency_list<
-    boost::vecS,
-    boost::vecS,
-    boost::bidirectionalS,
-    TaskV,
-    boost::property<boost::edge_index_t, int>>>;
-using Vertex = Graph::vertex_descriptor;
+// Minimum cost, optimal PE and divided cost of every task under every
+// configuration, computed once from the cost matrix. Configurations are
+// referred to by their index in the Configurations they were computed from.
+class ConfigCosts {
+  public:
+  ConfigCosts(const CostMatrix &W, const Configurations &C);
+
+  size_t nconfigs() const;
+  int    min_cost(Vertex v, size_t c) const;
+  PE     optimal_pe(Vertex v, size_t c) const;
+  int    divided_cost(Vertex v, size_t c) const;
+  bool   supports(Vertex v, size_t c) const;
+
+  private:
+  size_t              _nconfigs;
+  std::vector<int>    _min_cost;
+  std::vector<size_t> _optimal_pe;
+  std::vector<int>    _divided_cost;
+};
+
+// Cost of reconfiguring from one configuration to another, referred to by
+// their indices in the Configurations. Loading the first configuration, i.e.
+// reconfiguring from any index >= nconfigs(), costs the initial cost of the
+// target configuration. Staying in a configuration is free.
+class ReconfigCosts {
+  public:
+  ReconfigCosts(size_t nconfigs, int rho);
+
+  size_t nconfigs() const;
+  int    cost(size_t from, size_t to) const;
+  void   set_cost(size_t from, size_t to, int cost);
+  void   set_initial(size_t to, int cost);
+
+  private:
+  size_t           _nconfigs;
+  std::vector<int> _cost;
+  std::vector<int> _initial;
+};
+
+// How tasks are placed on a PE: either always after the last task on the PE,
+// or into the earliest idle interval on the PE that fits the task.
+enum class Placement { Append, Insertion };
+
+// How configurations are switched: either globally, waiting for all PEs and
+// blocking them during the reconfiguration, or partially, reconfiguring only
+// the region of the PE a task runs on while the other regions keep running.
+// The k-th PE of every configuration occupies region k.
+enum class Reconfiguration { Global, Partial };
+
+// Ordered index of the idle intervals [start, end] of a single PE. The last
+// interval is open and ends at Open.
+class IdleIntervals {
+  public:
+  static constexpr int Open = std::numeric_limits<int>::max();
+
+  explicit IdleIntervals(std::pmr::memory_resource *mem);
+
+  int  earliest_fit(int ready, int cost) const;
+  void reserve(int t_s, int t_f);
+
+  private:
+  std::pmr::map<int, int> intervals;
+};
 
 struct Schedule {
   struct ScheduledTask {
-    ScheduledTask(const TaskV &v, const PE &pe, int start)
+    ScheduledTask(Vertex v, const PE &pe, int start, int cost)
       : task(v)
       , p(pe)
       , _t_s(start)
+      , _cost(cost)
     {
-      assert(task.cost(pe));
+      assert(cost != CostMatrix::Unsupported);
     }
 
     int cost() const;
     int t_s() const;
     int t_f() const;
     PE  pe() const;
-    TaskV vertex() const;
+    Vertex vertex() const;
 
   private:
-    TaskV task;
+    Vertex task;
     PE    p;
     int   _t_s;
+    int   _cost;
   };
 
+  // Non-owning view of the tasks on a PE, ordered by start time
+  using Timeline = boost::iterator_range<boost::permutation_iterator<
+      std::pmr::vector<ScheduledTask>::const_iterator,
+      std::pmr::vector<size_t>::const_iterator>>;
+
 public:
-  explicit Schedule(const Configurations &C);
+  // All state of the schedule is allocated from mem, e.g. a per-run Arena
+  explicit Schedule(
+      const Configurations      &C,
+      const CostMatrix          &W,
+      Placement                  placement = Placement::Append,
+      std::pmr::memory_resource *mem = std::pmr::get_default_resource());
   int                        max_t_f(const PE &p) const;
-  std::vector<ScheduledTask> tasks_on_pe(const PE &p) const;
-  ScheduledTask             &schedule_task(TaskV v, PE p, int t_s);
-  ScheduledTask             &schedule_task(TaskV v, PE p);
-  int                        insert_reconfiguration(int rho);
-  int                        t_f(TaskV v);
+  Timeline                   tasks_on_pe(const PE &p) const;
+  ScheduledTask             &schedule_task(Vertex v, PE p, int t_s);
+  ScheduledTask             &schedule_task(Vertex v, PE p);
+  int                        insert_reconfiguration(int cost);
+  int                        t_f(Vertex v) const;
   int                        makespan() const;
-  std::pair<PE, int>         earliest_finish(const TaskV &);
-  std::pair<PE, int>         asap(const Configuration &, const TaskV &);
-  std::pair<PE, int> earliest_finish(const TaskV &, const Configuration &);
+  std::pair<PE, int>         earliest_finish(Vertex);
+  std::pair<PE, int>         asap(const Configuration &, Vertex);
+  std::pair<PE, int>         earliest_finish(Vertex, const Configuration &);
+  std::pair<PE, int> earliest_gap(const Configuration &, Vertex, int ready) const;
+  std::pair<PE, int> earliest_region(
+      const ReconfigCosts &R, size_t c, Vertex, int ready) const;
+  ScheduledTask &schedule_on_region(
+      const ReconfigCosts &R, Vertex v, PE p, int t_s);
 
   friend std::ostream &operator<<(std::ostream &os, const Schedule &S);
 
-  std::vector<ScheduledTask>            scheduled_tasks;
-  Configurations                        confs;
-  std::vector<int>                      reconfigs;
-  std::unordered_map<PE, int, PE::Hash> pe_t_f;
+  std::pmr::vector<ScheduledTask>            scheduled_tasks;
+  Configurations const                      *confs = nullptr;
+  CostMatrix const                          *W     = nullptr;
+  Placement                                  placement;
+  // Start time, duration and region (NoRegion for global ones) of each
+  // reconfiguration
+  std::pmr::vector<int>                      reconfigs;
+  std::pmr::vector<int>                      reconfig_costs;
+  std::pmr::vector<size_t>                   reconfig_regions;
+  // Finish time of the last task on each PE, indexed by PE offset
+  std::pmr::vector<int>                      pe_t_f;
+  // Maximum of pe_t_f, i.e. the latest finish time of all tasks
+  int                                        max_pe_t_f = 0;
+  // Indices into scheduled_tasks of the tasks on each PE ordered by their
+  // start time, indexed by PE offset
+  std::pmr::vector<std::pmr::vector<size_t>> pe_tasks;
+  // Index into confs of the configuration each PE belongs to, indexed by PE
+  // offset (NoConfig for PEs which are not part of any configuration)
+  std::pmr::vector<size_t>                   pe_config;
+  // Finish time of each task, indexed by its vertex descriptor (-1 if the
+  // task has not been scheduled yet)
+  std::pmr::vector<int>                      task_t_f;
+  // Idle intervals of each PE, indexed by PE offset (only maintained for
+  // Placement::Insertion)
+  std::pmr::vector<IdleIntervals>            pe_idle;
+  // Region of each PE, indexed by PE offset, and the configuration loaded
+  // into each region and the time it is busy until, indexed by region (only
+  // maintained for Reconfiguration::Partial)
+  std::pmr::vector<size_t>                   pe_region;
+  std::pmr::vector<size_t>                   region_config;
+  std::pmr::vector<int>                      region_t_f;
+
+  static constexpr size_t NoConfig = std::numeric_limits<size_t>::max();
+  static constexpr size_t NoRegion = std::numeric_limits<size_t>::max();
+
+private:
+  template <typename PEIt>
+  PEIt earliest_pe(PEIt first, PEIt last, Vertex v) const;
 };
@@ -0,0 +1,124 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(size_t nthreads)
+{
+  // A pool of a single thread runs everything on the calling thread
+  if (nthreads <= 1) {
+    return;
+  }
+  workers.reserve(nthreads);
+  for (size_t i = 0; i < nthreads; i++) {
+    workers.emplace_back([this]() { run(); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  available.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::size() const
+{
+  return std::max<size_t>(workers.size(), 1);
+}
+
+void ThreadPool::run()
+{
+  while (true) {
+    std::function<void()> job;
+    Batch                *batch = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      available.wait(
+          lock, [this]() { return stop || batches || !jobs.empty(); });
+      if (batches) {
+        // Helping a waiting parallel_for() takes precedence over new jobs
+        batch = batches;
+        {
+          std::lock_guard<std::mutex> batch_lock(batch->mutex);
+          batch->active++;
+        }
+        if (--batch->wanted == 0) {
+          batches = batch->older;
+        }
+      }
+      else if (jobs.empty()) {
+        return;
+      }
+      else {
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+    }
+    if (batch) {
+      work(*batch);
+      // The batch may be destroyed as soon as its mutex is released
+      std::lock_guard<std::mutex> lock(batch->mutex);
+      if (--batch->active == 0) {
+        batch->done.notify_all();
+      }
+    }
+    else {
+      job();
+    }
+  }
+}
+
+void ThreadPool::work(Batch &batch)
+{
+  for (size_t i = batch.next++; i < batch.end; i = batch.next++) {
+    batch.call(batch.f, i);
+  }
+}
+
+void ThreadPool::parallel_for(
+    size_t begin, size_t end, void (*call)(void *, size_t), void *f)
+{
+  if (begin >= end) {
+    return;
+  }
+  if (workers.empty() || end - begin == 1) {
+    for (size_t i = begin; i < end; i++) {
+      call(f, i);
+    }
+    return;
+  }
+
+  // Indices are handed out one by one to whichever thread asks next. The
+  // batch stays on this stack: once this thread runs out of indices, it
+  // withdraws the helpers which have not started yet and waits for the
+  // others, so no helper refers to the batch after it returns.
+  Batch batch;
+  batch.call = call;
+  batch.f    = f;
+  batch.next.store(begin);
+  batch.end    = end;
+  batch.wanted = std::min(workers.size(), end - begin - 1);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    batch.older = batches;
+    batches     = &batch;
+  }
+  available.notify_all();
+
+  work(batch);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Batch **link = &batches; *link; link = &(*link)->older) {
+      if (*link == &batch) {
+        *link = batch.older;
+        break;
+      }
+    }
+  }
+  std::unique_lock<std::mutex> lock(batch.mutex);
+  batch.done.wait(lock, [&]() { return batch.active == 0; });
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed size pool of worker threads executing submitted jobs in FIFO order.
+class ThreadPool {
+  public:
+  explicit ThreadPool(size_t nthreads = std::thread::hardware_concurrency());
+  ThreadPool(const ThreadPool &)            = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool();
+
+  size_t size() const;
+
+  template <typename F>
+  std::future<std::invoke_result_t<F>> submit(F f);
+
+  // Calls f(i) for every i in [begin, end) and returns once all calls are
+  // done. The calling thread takes part in the work, so parallel_for() may
+  // be used from within a job of the same pool without deadlocking. Does not
+  // allocate: f is referenced rather than copied and the shared state lives
+  // on the calling thread's stack.
+  template <typename F>
+  void parallel_for(size_t begin, size_t end, F &&f);
+
+  private:
+  // The indices of a parallel_for() still to be handed out, and the helpers
+  // it still wants to start on them
+  struct Batch {
+    void (*call)(void *, size_t);
+    void                   *f;
+    std::atomic<size_t>     next;
+    size_t                  end;
+    size_t                  wanted;
+    size_t                  active = 0;
+    std::mutex              mutex;
+    std::condition_variable done;
+    Batch                  *older  = nullptr;
+  };
+
+  void run();
+  void parallel_for(
+      size_t begin, size_t end, void (*call)(void *, size_t), void *f);
+  static void work(Batch &batch);
+
+  std::vector<std::thread>          workers;
+  std::deque<std::function<void()>> jobs;
+  // Most recent batch wanting helpers, linked to the older ones
+  Batch                            *batches = nullptr;
+  std::mutex                        mutex;
+  std::condition_variable           available;
+  bool                              stop = false;
+};
+
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::submit(F f)
+{
+  using Result = std::invoke_result_t<F>;
+
+  auto job    = std::make_shared<std::packaged_task<Result()>>(std::move(f));
+  auto result = job->get_future();
+  if (workers.empty()) {
+    (*job)();
+    return result;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.emplace_back([job]() { (*job)(); });
+  }
+  available.notify_one();
+  return result;
+}
+
+template <typename F>
+void ThreadPool::parallel_for(size_t begin, size_t end, F &&f)
+{
+  using Function = std::remove_reference_t<F>;
+  parallel_for(
+      begin,
+      end,
+      [](void *function, size_t i) { (*static_cast<Function *>(function))(i); },
+      const_cast<void *>(static_cast<const void *>(std::addressof(f))));
+}
@@ -1,3 +1,6 @@
+#include <optional>
+#include <stdexcept>
+
 #include "util.hpp"
 #include "scheduling.hpp"
 
@@ -10,13 +13,6 @@ Graph import_task_graph(const nlohmann::json &j)
   for (size_t i = 0; i < ntasks; i++) {
     auto v    = boost::vertex(i, g);
     g[v].name = j["tasklabels"][i].get<std::string>();
-    for (size_t c = 0; c < j["cost"][i].size(); c++) {
-      if(j["cost"][i][c].type() == nlohmann::json::value_t::boolean) {
-        g[v]._cost[c].reset();
-      } else {
-        g[v]._cost[c] = j["cost"][i][c].get<int>();
-      }
-    }
   }
 
   // Insert dependencies
@@ -31,6 +27,24 @@ Graph import_task_graph(const nlohmann::json &j)
   return g;
 }
 
+CostMatrix import_costs(const nlohmann::json &j)
+{
+  const size_t ntasks = j["deps"].size();
+  const size_t npes   = j["nprocs"].get<size_t>();
+  CostMatrix   W(ntasks, npes);
+
+  for (size_t i = 0; i < ntasks; i++) {
+    for (size_t c = 0; c < std::min(j["cost"][i].size(), npes); c++) {
+      // Tasks which cannot run on a PE have their cost set to false
+      if (j["cost"][i][c].type() != nlohmann::json::value_t::boolean) {
+        W.set_cost(i, PE(c), j["cost"][i][c].get<int>());
+      }
+    }
+  }
+
+  return W;
+}
+
 Configurations import_configs(const nlohmann::json &j)
 {
   std::vector<Configuration> confs;
@@ -49,14 +63,57 @@ Configurations import_configs(const nlohmann::json &j)
   return confs;
 }
 
-void export_svg(const Schedule &S, const std::string &filename)
+// Entry i of a cost array, none if the array is too short or the entry null
+static std::optional<int> cost_entry(
+    const nlohmann::json &costs, size_t i, const char *name)
+{
+  if (not costs.is_array() || i >= costs.size() || costs[i].is_null()) {
+    return std::nullopt;
+  }
+  if (not costs[i].is_number_integer()) {
+    throw std::invalid_argument(
+        std::string(name) + " entries must be integers or null");
+  }
+  return costs[i].get<int>();
+}
+
+ReconfigCosts import_reconfig_costs(
+    const nlohmann::json &j, size_t nconfigs, int rho)
+{
+  ReconfigCosts R(nconfigs, rho);
+
+  // rho_matrix[from][to] and rho_initial[to] override the scalar rho, short
+  // rows and null entries keep it
+  if (j.contains("rho_matrix")) {
+    const auto &matrix = j["rho_matrix"];
+    for (size_t from = 0; from < nconfigs; from++) {
+      if (not matrix.is_array() || from >= matrix.size()) {
+        break;
+      }
+      for (size_t to = 0; to < nconfigs; to++) {
+        if (auto cost = cost_entry(matrix[from], to, "rho_matrix");
+            cost && from != to) {
+          R.set_cost(from, to, *cost);
+        }
+      }
+    }
+  }
+  if (j.contains("rho_initial")) {
+    for (size_t to = 0; to < nconfigs; to++) {
+      if (auto cost = cost_entry(j["rho_initial"], to, "rho_initial")) {
+        R.set_initial(to, *cost);
+      }
+    }
+  }
+
+  return R;
+}
+
+void export_svg(const Schedule &S, const DAG &g, const std::string &filename)
 {
   using namespace svg;
 
-  auto max = std::max_element(
-      S.pe_t_f.begin(), S.pe_t_f.end(), [](const auto &lhs, const auto &rhs) {
-        return lhs.second < rhs.second;
-      });
+  const int max = S.makespan();
 
   Point       p_origin(10, 10);
   const int   x_scale    = 50;
@@ -73,19 +130,42 @@ void export_svg(const Schedule &S, const std::string &filename)
 
   Dimensions dimensions(
       p_origin.x + pes * x_scale,
-      p_origin.y + max->second * y_scale);
+      p_origin.y + max * y_scale);
   Document doc(filename, Layout(dimensions, Layout::TopLeft));
 
   size_t c_index = 2;
   int reconf_index = 1;
-  for(auto reconfig : S.reconfigs) {
-    Point reconf_origin(p_origin.x, reconfig * y_scale);
+  // Column of each PE, in the order the PEs are drawn below
+  std::vector<int> pe_column(pes, 0);
+  int              column = 0;
+  for (const auto &c : *S.confs) {
+    for (auto pe : c.pes) {
+      pe_column[pe.offset] = column++;
+    }
+  }
+
+  for (size_t r = 0; r < S.reconfigs.size(); r++) {
+    Point reconf_origin(p_origin.x, S.reconfigs[r] * y_scale);
     Point text_origin(reconf_origin.x + 1, reconf_origin.y + 10);
-    doc << Rectangle(
-        reconf_origin,
-        x_scale * pes,
-        rho * y_scale,
-        Fill(Color::Yellow));
+    if (S.reconfig_regions[r] == Schedule::NoRegion) {
+      doc << Rectangle(
+          reconf_origin,
+          x_scale * pes,
+          S.reconfig_costs[r] * y_scale,
+          Fill(Color::Yellow));
+    }
+    else {
+      // A partial reconfiguration blocks the PEs of its region only
+      for (int pe = 0; pe < pes; pe++) {
+        if (S.pe_region[pe] == S.reconfig_regions[r]) {
+          doc << Rectangle(
+              Point(p_origin.x + pe_column[pe] * x_scale, reconf_origin.y),
+              x_scale,
+              S.reconfig_costs[r] * y_scale,
+              Fill(Color::Yellow));
+        }
+      }
+    }
     doc << Text(
         text_origin,
         "Reconfig #" + std::to_string(reconf_index++),
@@ -93,10 +173,9 @@ void export_svg(const Schedule &S, const std::string &filename)
         Font(10, "Verdana"));
   }
 
-  for (auto c : S.confs) {
+  for (const auto &c : *S.confs) {
     for (auto pe : c.pes) {
-      auto tasks = S.tasks_on_pe(pe);
-      for (auto task : tasks) {
+      for (const auto &task : S.tasks_on_pe(pe)) {
         Point task_origin(p_origin.x, task.t_s() * y_scale);
         Point text_origin(task_origin.x + 1, task_origin.y + 10);
         doc << Rectangle(
@@ -107,7 +186,7 @@ void export_svg(const Schedule &S, const std::string &filename)
             Stroke(1, static_cast<Color::Defaults>(c_index)));
         doc << Text(
             text_origin,
-            task.vertex().name,
+            g.name(task.vertex()),
             Color::Black,
             Font(10, "Verdana"));
       }
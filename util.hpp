@@ -2,12 +2,16 @@
 
 #define JSON_USE_IMPLICIT_CONVERSIONS 0
 
+#include "dag.hpp"
 #include "json.hpp"
 #include "scheduling.hpp"
 #include "simple_svg.hpp"
 
-extern int rho;
-
 Graph          import_task_graph(const nlohmann::json &);
+CostMatrix     import_costs(const nlohmann::json &);
 Configurations import_configs(const nlohmann::json &);
-void           export_svg(const Schedule &, const std::string &);
+// Reconfiguration costs from the optional rho_matrix and rho_initial entries,
+// rho where they are missing or null. Throws std::invalid_argument on entries
+// which are not integers.
+ReconfigCosts  import_reconfig_costs(const nlohmann::json &, size_t, int rho);
+void export_svg(const Schedule &, const DAG &, const std::string &);